@@ -0,0 +1,121 @@
+#include "diagnostics.h"
+#include <QStringList>
+
+// 默认只输出警告及以上级别，调试级日志需要手动开启
+Q_LOGGING_CATEGORY(lcFamilyTreeSearch, "familytree.search", QtWarningMsg)
+Q_LOGGING_CATEGORY(lcFamilyTreeEdit, "familytree.edit", QtWarningMsg)
+Q_LOGGING_CATEGORY(lcFamilyTreeUi, "familytree.ui", QtWarningMsg)
+// 服务模式没有界面，监听地址等启动信息需要默认输出
+Q_LOGGING_CATEGORY(lcFamilyTreeService, "familytree.service", QtInfoMsg)
+
+void PerfCounter::record(qint64 ns) {
+    ++calls;
+    totalNs += ns;
+    if (ns > maxNs) {
+        maxNs = ns;
+    }
+
+    // 按微秒的二进制位数分桶
+    quint64 us = static_cast<quint64>(ns / 1000);
+    int bucket = 0;
+    while (us > 0 && bucket < BucketCount - 1) {
+        us >>= 1;
+        ++bucket;
+    }
+    ++buckets[bucket];
+}
+
+qint64 PerfCounter::percentileUs(double p) const {
+    if (calls == 0) {
+        return 0;
+    }
+
+    const quint64 target = static_cast<quint64>(p * calls + 0.5);
+    quint64 seen = 0;
+    for (int i = 0; i < BucketCount - 1; ++i) {
+        seen += buckets[i];
+        if (seen >= target && seen > 0) {
+            return qint64(1) << i;  // 桶的上界
+        }
+    }
+    return maxNs / 1000;  // 落在溢出桶中，用最大值近似
+}
+
+PerfStats& PerfStats::instance() {
+    static PerfStats stats;
+    return stats;
+}
+
+void PerfStats::reset() {
+    for (auto& c : counters) {
+        c = PerfCounter();
+    }
+}
+
+const char* PerfStats::opName(PerfOp op) {
+    switch (op) {
+    case PerfOp::AddMember: return "addMember";
+    case PerfOp::AddSpouse: return "addSpouse";
+    case PerfOp::AddSibling: return "addSibling";
+    case PerfOp::ModifyMember: return "modifyMember";
+    case PerfOp::ModifySpouse: return "modifySpouseDetails";
+    case PerfOp::FindMember: return "findMember";
+    case PerfOp::RefreshTree: return "refreshTree";
+    case PerfOp::ExportCsv: return "exportCsv";
+    case PerfOp::ServiceRequest: return "serviceRequest";
+    case PerfOp::Count: break;
+    }
+    return "unknown";
+}
+
+QString PerfStats::report(bool withHistogram) const {
+    QStringList lines;
+    lines << QString("%1 %2 %3 %4 %5 %6")
+                 .arg("操作", -22)
+                 .arg("次数", 8)
+                 .arg("平均(us)", 10)
+                 .arg("p50(us)", 10)
+                 .arg("p99(us)", 10)
+                 .arg("最大(us)", 10);
+
+    for (int i = 0; i < static_cast<int>(PerfOp::Count); ++i) {
+        const PerfCounter& c = counters[i];
+        const qint64 avgUs = c.calls ? c.totalNs / qint64(c.calls) / 1000 : 0;
+        lines << QString("%1 %2 %3 %4 %5 %6")
+                     .arg(QString::fromLatin1(opName(static_cast<PerfOp>(i))), -22)
+                     .arg(c.calls, 8)
+                     .arg(avgUs, 10)
+                     .arg(c.percentileUs(0.50), 10)
+                     .arg(c.percentileUs(0.99), 10)
+                     .arg(c.maxNs / 1000, 10);
+    }
+
+    if (withHistogram) {
+        // 逐个操作列出非空的桶：区间 [下界, 上界) 微秒及样本数
+        lines << "" << "延迟分布（单位 us）：";
+        for (int i = 0; i < static_cast<int>(PerfOp::Count); ++i) {
+            const PerfCounter& c = counters[i];
+            if (c.calls == 0) {
+                continue;
+            }
+            lines << QString::fromLatin1(opName(static_cast<PerfOp>(i)));
+            for (int b = 0; b < PerfCounter::BucketCount; ++b) {
+                if (c.buckets[b] == 0) {
+                    continue;
+                }
+                const qint64 lower = b == 0 ? 0 : qint64(1) << (b - 1);
+                const QString range = b == PerfCounter::BucketCount - 1
+                                          ? QString(">= %1").arg(lower)
+                                          : QString("[%1, %2)").arg(lower).arg(qint64(1) << b);
+                lines << QString("  %1 %2").arg(range, -20).arg(c.buckets[b], 10);
+            }
+        }
+    }
+    return lines.join('\n');
+}
+
+// 注意：QT_LOGGING_RULES 环境变量的优先级高于这里设置的规则
+void setVerboseLogging(bool enabled) {
+    QLoggingCategory::setFilterRules(enabled ? QStringLiteral("familytree.*.debug=true")
+                                             : QStringLiteral("familytree.*.debug=false"));
+}
@@ -0,0 +1,87 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <QLoggingCategory>
+#include <QElapsedTimer>
+#include <QString>
+#include <QtGlobal>
+
+// 日志分类：调试级输出默认关闭，可在运行时通过诊断面板或 QT_LOGGING_RULES 打开
+Q_DECLARE_LOGGING_CATEGORY(lcFamilyTreeSearch)  // 查找路径（每访问一个节点一条，热点路径）
+Q_DECLARE_LOGGING_CATEGORY(lcFamilyTreeEdit)    // 成员增删改
+Q_DECLARE_LOGGING_CATEGORY(lcFamilyTreeUi)      // 界面操作（切换家谱、刷新等）
+Q_DECLARE_LOGGING_CATEGORY(lcFamilyTreeService) // 本地家谱服务（连接与请求）
+
+// 需要统计耗时的操作
+enum class PerfOp {
+    AddMember,
+    AddSpouse,
+    AddSibling,
+    ModifyMember,
+    ModifySpouse,
+    FindMember,
+    RefreshTree,
+    ExportCsv,
+    ServiceRequest,
+    Count
+};
+
+// 单个操作的计数与延迟直方图
+// 第 0 桶统计 <1us 的样本，第 i 桶统计 [2^(i-1), 2^i) us 的样本，最后一桶收纳更长的样本
+struct PerfCounter {
+    static constexpr int BucketCount = 24;
+
+    quint64 calls = 0;  // 调用次数
+    qint64 totalNs = 0;  // 累计耗时（纳秒）
+    qint64 maxNs = 0;  // 最长一次耗时（纳秒）
+    quint64 buckets[BucketCount] = {};  // 延迟直方图
+
+    void record(qint64 ns);
+    qint64 percentileUs(double p) const;  // 由直方图估算分位数（取桶上界，单位微秒）
+};
+
+// 全局性能统计表，不加锁：只在主线程（界面或 --serve 模式下的服务事件循环）中使用
+class PerfStats {
+public:
+    static PerfStats& instance();
+
+    void record(PerfOp op, qint64 ns) { counters[static_cast<int>(op)].record(ns); }
+    const PerfCounter& counter(PerfOp op) const { return counters[static_cast<int>(op)]; }
+    void reset();
+    QString report(bool withHistogram = false) const;  // 生成文本格式的统计报告，可附带各操作的非空直方图桶
+
+    static const char* opName(PerfOp op);
+
+private:
+    PerfStats() = default;
+    PerfCounter counters[static_cast<int>(PerfOp::Count)];
+};
+
+// 作用域计时器：构造时开始计时，析构时把耗时记入 PerfStats
+class PerfScope {
+public:
+    explicit PerfScope(PerfOp op) : op(op) { timer.start(); }
+    ~PerfScope() { PerfStats::instance().record(op, timer.nsecsElapsed()); }
+    PerfScope(const PerfScope&) = delete;
+    PerfScope& operator=(const PerfScope&) = delete;
+
+private:
+    PerfOp op;
+    QElapsedTimer timer;
+};
+
+// 单棵家谱的内存占用估算
+struct TreeMemoryStats {
+    int memberCount = 0;  // 树上的成员数（不含配偶）
+    int spouseCount = 0;  // 配偶节点数
+    qint64 nodeBytes = 0;  // FamilyMember 对象本身
+    qint64 stringBytes = 0;  // 名称与详细信息字符串
+    qint64 edgeBytes = 0;  // children / spouses 指针数组
+    qint64 indexBytes = 0;  // 世系键及其有序索引
+    qint64 totalBytes() const { return nodeBytes + stringBytes + edgeBytes + indexBytes; }
+};
+
+// 打开或关闭所有分类的调试级日志
+void setVerboseLogging(bool enabled);
+
+#endif // DIAGNOSTICS_H
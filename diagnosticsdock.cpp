@@ -0,0 +1,156 @@
+#include "diagnosticsdock.h"
+#include "diagnostics.h"
+#include <QPlainTextEdit>
+#include <QCheckBox>
+#include <QPushButton>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QTimer>
+#include <QFile>
+#include <QTextStream>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QFontDatabase>
+#include <QScrollBar>
+
+DiagnosticsDock::DiagnosticsDock(QWidget *parent) :
+    QDockWidget("性能诊断", parent),
+    reportView(new QPlainTextEdit),
+    verboseCheck(new QCheckBox("详细日志")),
+    refreshTimer(new QTimer(this))
+{
+    setObjectName("diagnosticsDock");
+
+    reportView->setReadOnly(true);
+    reportView->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont)); // 等宽字体便于对齐表格
+    reportView->setLineWrapMode(QPlainTextEdit::NoWrap);
+
+    auto refreshButton = new QPushButton("刷新");
+    auto resetButton = new QPushButton("清零");
+    auto dumpButton = new QPushButton("导出");
+
+    auto buttonRow = new QHBoxLayout;
+    buttonRow->addWidget(verboseCheck);
+    buttonRow->addStretch();
+    buttonRow->addWidget(refreshButton);
+    buttonRow->addWidget(resetButton);
+    buttonRow->addWidget(dumpButton);
+
+    auto container = new QWidget;
+    auto layout = new QVBoxLayout(container);
+    layout->addLayout(buttonRow);
+    layout->addWidget(reportView);
+    setWidget(container);
+
+    connect(refreshButton, &QPushButton::clicked, this, &DiagnosticsDock::refreshReport);
+    connect(resetButton, &QPushButton::clicked, this, &DiagnosticsDock::onResetStats);
+    connect(dumpButton, &QPushButton::clicked, this, &DiagnosticsDock::onDumpReport);
+    // 开关状态以日志分类的实际状态为准；QT_LOGGING_RULES 的优先级高于 setFilterRules，设置后开关无效
+    verboseCheck->setChecked(lcFamilyTreeSearch().isDebugEnabled());
+    if (qEnvironmentVariableIsSet("QT_LOGGING_RULES")) {
+        verboseCheck->setEnabled(false);
+        verboseCheck->setToolTip("日志级别已由环境变量 QT_LOGGING_RULES 指定");
+    }
+    connect(verboseCheck, &QCheckBox::toggled, this, [](bool checked) {
+        setVerboseLogging(checked); // 运行时切换调试级日志
+    });
+
+    // 只在面板可见时定时刷新，避免隐藏时产生额外开销
+    refreshTimer->setInterval(1000);
+    connect(refreshTimer, &QTimer::timeout, this, &DiagnosticsDock::refreshPerfStats);
+    connect(this, &QDockWidget::visibilityChanged, this, [this](bool visible) {
+        if (visible) {
+            refreshReport();
+            refreshTimer->start();
+        } else {
+            refreshTimer->stop();
+        }
+    });
+}
+
+void DiagnosticsDock::setMemoryReportProvider(std::function<QString()> provider) {
+    memoryReportProvider = std::move(provider);
+}
+
+// 面板只显示汇总表，导出的文件附带完整的延迟直方图
+QString DiagnosticsDock::fullReport(bool withHistogram) const {
+    QString report = "== 操作耗时 ==\n" + PerfStats::instance().report(withHistogram);
+    if (!serviceReport.isEmpty()) {
+        report += QString("\n\n== 服务端操作耗时（采集于 %1，点击“刷新”更新）==\n")
+                      .arg(serviceReportTime.toString("HH:mm:ss"))
+                  + serviceReport;
+    }
+    return report + "\n\n== 家谱内存占用（点击“刷新”更新）==\n" + memoryReport;
+}
+
+void DiagnosticsDock::setServiceReportEnabled(bool enabled) {
+    serviceReportEnabled = enabled;
+    if (!enabled && pendingDump) {
+        writeDump(pendingDump); // 不会再收到服务端统计，按已有数据导出
+        pendingDump = nullptr;
+    }
+}
+
+void DiagnosticsDock::setServiceReport(const QString& report) {
+    serviceReport = report;
+    serviceReportTime = QDateTime::currentDateTime();
+    refreshPerfStats();
+
+    if (pendingDump) {
+        writeDump(pendingDump);
+        pendingDump = nullptr;
+    }
+}
+
+void DiagnosticsDock::refreshReport() {
+    if (memoryReportProvider) {
+        memoryReport = memoryReportProvider();
+    }
+    emit refreshRequested();
+    refreshPerfStats();
+}
+
+void DiagnosticsDock::refreshPerfStats() {
+    // 保留滚动位置，避免定时刷新时跳回顶部
+    const int scroll = reportView->verticalScrollBar()->value();
+    reportView->setPlainText(fullReport());
+    reportView->verticalScrollBar()->setValue(scroll);
+}
+
+void DiagnosticsDock::onResetStats() {
+    PerfStats::instance().reset();
+    refreshPerfStats();
+}
+
+void DiagnosticsDock::onDumpReport() {
+    QString fileName = QFileDialog::getSaveFileName(this, "导出诊断报告", "", "文本文件 (*.txt)");
+    if (fileName.isEmpty()) {
+        return; // 用户取消操作
+    }
+
+    auto file = new QFile(fileName, this);
+    if (!file->open(QIODevice::WriteOnly | QIODevice::Text)) {
+        QMessageBox::critical(this, "错误", "无法打开文件进行写入！");
+        delete file;
+        return;
+    }
+
+    if (pendingDump) {
+        writeDump(pendingDump); // 上一次导出仍在等待，先按已有数据写出
+        pendingDump = nullptr;
+    }
+
+    refreshReport(); // 导出前重新统计内存占用，共享模式下同时请求服务端统计
+    if (serviceReportEnabled) {
+        pendingDump = file; // 服务端统计是异步返回的，收到后再写文件
+    } else {
+        writeDump(file);
+    }
+}
+
+void DiagnosticsDock::writeDump(QFile* file) {
+    QTextStream out(file);
+    out << fullReport(true) << Qt::endl;
+    file->close();
+    file->deleteLater();
+}
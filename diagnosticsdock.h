@@ -0,0 +1,52 @@
+#ifndef DIAGNOSTICSDOCK_H
+#define DIAGNOSTICSDOCK_H
+
+#include <QDockWidget>
+#include <QDateTime>
+#include <functional>
+
+class QPlainTextEdit;
+class QCheckBox;
+class QTimer;
+class QFile;
+
+// 性能诊断面板：展示各操作的计数、延迟分布以及家谱内存占用，并可导出到文件
+// 操作耗时表开销很小，面板可见时每秒刷新；内存占用需要遍历全部家谱，只在打开面板、点击“刷新”或导出时重新统计
+class DiagnosticsDock : public QDockWidget {
+    Q_OBJECT
+
+public:
+    explicit DiagnosticsDock(QWidget *parent = nullptr);
+
+    // 设置内存占用报告的来源，由主窗口遍历家谱生成
+    void setMemoryReportProvider(std::function<QString()> provider);
+    // 共享模式下打开：导出时等收到服务端统计后再写文件；关闭时立即写出等待中的导出
+    void setServiceReportEnabled(bool enabled);
+
+public slots:
+    void refreshReport();  // 重新统计内存占用并刷新面板
+    void setServiceReport(const QString& report);  // 显示共享模式下服务端的操作耗时
+
+signals:
+    void refreshRequested();  // 请求刷新时发出，共享模式下用于向服务端拉取统计
+
+private slots:
+    void onDumpReport();  // 导出诊断报告
+    void onResetStats();  // 清空统计数据
+    void refreshPerfStats();  // 只刷新操作耗时表
+
+private:
+    QPlainTextEdit* reportView;  // 报告显示区域
+    QCheckBox* verboseCheck;  // 详细日志开关
+    QTimer* refreshTimer;  // 面板可见时定时刷新
+    std::function<QString()> memoryReportProvider;
+    QString memoryReport;  // 最近一次统计的内存占用
+    QString serviceReport;  // 最近一次收到的服务端操作耗时，单机模式下为空
+    QDateTime serviceReportTime;  // 收到 serviceReport 的时间
+    bool serviceReportEnabled = false;
+    QFile* pendingDump = nullptr;  // 已打开、等待服务端统计的导出文件
+    void writeDump(QFile* file);  // 写出完整报告并关闭文件
+    QString fullReport(bool withHistogram = false) const;  // 拼接操作耗时与内存占用，可附带延迟直方图
+};
+
+#endif // DIAGNOSTICSDOCK_H
@@ -0,0 +1,325 @@
+#include "familytree.h"
+#include <QDebug>
+#include <QtEndian>
+// 默认构造函数，初始化家谱树时设置根节点为空
+FamilyTree::FamilyTree() : root(nullptr) {}
+// 带名称的构造函数，用于创建一个命名的家谱树，并初始化根节点为空
+FamilyTree::FamilyTree(const QString& name) : treeName(name), root(nullptr) {}
+
+// 修改配偶详细信息
+// 输入：成员名称、配偶名称、新的配偶详细信息
+bool FamilyTree::modifySpouseDetails(const QString& memberName, const QString& spouseName, const QString& newDetails) {
+    PerfScope perf(PerfOp::ModifySpouse);
+    // 查找指定的成员
+    auto member = findMember(memberName);
+    if (member) {
+        // 遍历成员的配偶列表
+        for (auto& spouse : member->spouses) {
+            // 如果找到匹配的配偶，更新其详细信息
+            if (spouse->name == spouseName) {
+                spouse->details = newDetails; // 更新配偶详细信息
+                qCDebug(lcFamilyTreeEdit) << "成功修改配偶信息: " << spouseName << " -> " << newDetails;
+                return true;
+            }
+        }
+        // 如果未找到配偶，输出日志信息
+        qCWarning(lcFamilyTreeEdit) << "未找到配偶: " << spouseName << " -> 属于成员: " << memberName;
+    } else {
+        // 如果未找到成员，输出日志信息
+        qCWarning(lcFamilyTreeEdit) << "未找到成员: " << memberName;
+    }
+    return false;
+}
+
+// 添加成员到家谱树
+// 输入：父节点名称（如果为空表示添加根节点）、新成员名称、新成员详细信息
+bool FamilyTree::addMember(const QString& parentName, const QString& name, const QString& details) {
+    PerfScope perf(PerfOp::AddMember);
+    qCDebug(lcFamilyTreeEdit) << "Attempting to add member: " << name << " with parent: " << (parentName.isEmpty() ? "ROOT" : parentName);
+
+    // 创建新的家庭成员对象
+    auto newMember = std::make_shared<FamilyMember>(name, details);
+
+    if (parentName.isEmpty()) {
+        // 如果父节点名称为空，检查是否存在根节点
+        if (!root) {
+            // 如果根节点不存在，将新成员设置为根节点
+            attachMember(nullptr, newMember);
+            qCDebug(lcFamilyTreeEdit) << "Root member added: " << name;
+            return true;
+        } else {
+            // 如果根节点已存在，输出提示信息
+            qCWarning(lcFamilyTreeEdit) << "Root member already exists! Current root: " << root->name;
+        }
+    } else {
+        // 查找指定的父节点
+        auto parent = findMember(parentName);
+        if (parent) {
+            // 如果找到父节点，将新成员添加为其子节点
+            attachMember(parent, newMember);
+            qCDebug(lcFamilyTreeEdit) << "Child member added: " << name << " to parent: " << parentName;
+            return true;
+        } else {
+            // 如果未找到父节点，输出提示信息
+            qCWarning(lcFamilyTreeEdit) << "Parent not found! ParentName: " << parentName;
+            qCWarning(lcFamilyTreeEdit) << "Check if the parent name matches the root node or other nodes exactly.";
+        }
+    }
+    return false;
+}
+
+bool FamilyTree::addSpouse(const QString& memberName, const QString& spouseName, const QString& spouseDetails) {
+    PerfScope perf(PerfOp::AddSpouse);
+    // 查找目标成员
+    auto member = findMember(memberName);
+    if (member) {
+        // 检查配偶列表中是否已经存在该配偶
+        for (const auto& spouse : member->spouses) {
+            if (spouse->name == spouseName) {
+                // 如果配偶已存在，输出提示信息并返回
+                qCWarning(lcFamilyTreeEdit) << "配偶已存在: " << spouseName;
+                return false;
+            }
+        }
+
+        // 创建一个新配偶对象
+        auto newSpouse = std::make_shared<FamilyMember>(spouseName, spouseDetails);
+
+        // 将新配偶添加到成员的配偶列表中
+        member->spouses.append(newSpouse);
+
+        // 建立双向关联：将当前成员添加到新配偶的配偶列表中
+        newSpouse->spouses.append(member);
+
+        // 输出成功添加配偶的信息
+        qCDebug(lcFamilyTreeEdit) << "成功添加配偶: " << spouseName << " -> " << memberName;
+        return true;
+    } else {
+        // 如果未找到目标成员，输出提示信息
+        qCWarning(lcFamilyTreeEdit) << "未找到成员: " << memberName;
+        return false;
+    }
+}
+bool FamilyTree::modifyMember(const QString& name, const QString& newDetails) {
+    PerfScope perf(PerfOp::ModifyMember);
+    // 调用 findMember 方法查找指定名称的成员
+    auto member = findMember(name);
+    if (member) {
+        // 如果成员找到，更新其详细信息
+        member->details = newDetails;
+        qCDebug(lcFamilyTreeEdit) << "Successfully updated member details for: " << name;
+        return true;
+    } else {
+        // 如果未找到成员，输出错误信息
+        qCWarning(lcFamilyTreeEdit) << "Member not found!";
+        return false;
+    }
+}
+
+std::shared_ptr<FamilyMember> FamilyTree::findMember(const QString& name) {
+    PerfScope perf(PerfOp::FindMember);
+    // 从根节点开始递归查找成员
+    return findRecursive(name, root);
+}
+
+std::shared_ptr<FamilyMember> FamilyTree::findRecursive(const QString& name, std::shared_ptr<FamilyMember> node) {
+    if (!node) {
+        // 如果当前节点为空，返回 nullptr
+        qCDebug(lcFamilyTreeSearch) << "Node is null, returning nullptr";
+        return nullptr;
+    }
+
+    // 输出日志信息，显示当前检查的节点
+    qCDebug(lcFamilyTreeSearch) << "Checking node: " << node->name;
+
+    // 如果找到匹配的节点，返回该节点
+    if (node->name == name) {
+        qCDebug(lcFamilyTreeSearch) << "Found matching node: " << node->name;
+        return node;
+    }
+
+    // 遍历当前节点的所有子节点
+    for (const auto& child : node->children) {
+        // 输出日志信息，表示正在检查子节点
+        qCDebug(lcFamilyTreeSearch) << "Descending into child: " << child->name;
+
+        // 递归调用 findRecursive 检查子节点
+        auto found = findRecursive(name, child);
+        if (found) {
+            return found; // 如果找到匹配的节点，则返回
+        }
+    }
+
+    // 如果在当前分支中未找到目标节点，输出日志信息
+    qCDebug(lcFamilyTreeSearch) << "Node not found in this branch: " << name;
+    return nullptr; // 未找到匹配的节点，返回 nullptr
+}
+
+// 把成员挂到 parent 之下（parent 为空表示作为根节点），同时生成世系键并登记到索引
+// 子节点只会追加、不会删除，因此追加前的 children.size() 就是新成员唯一且递增的序号
+void FamilyTree::attachMember(const std::shared_ptr<FamilyMember>& parent, const std::shared_ptr<FamilyMember>& member) {
+    quint32 ordinal = 0;
+    if (parent) {
+        member->lineageKey = parent->lineageKey;
+        ordinal = static_cast<quint32>(parent->children.size());
+        parent->children.append(member);
+    } else {
+        member->lineageKey.clear();
+        root = member;
+    }
+
+    // 大端编码保证字节序比较与数值比较一致
+    char component[sizeof(quint32)];
+    qToBigEndian(ordinal, component);
+    member->lineageKey.append(component, sizeof(component));
+    lineageIndex.insert(member->lineageKey, member);
+}
+
+bool FamilyTree::isDescendant(const std::shared_ptr<FamilyMember>& member, const std::shared_ptr<FamilyMember>& ancestor) const {
+    if (!member || !ancestor || ancestor->lineageKey.isEmpty()) return false;
+
+    // 祖先的键是后代键的真前缀，不需要遍历树
+    return member->lineageKey.size() > ancestor->lineageKey.size()
+           && member->lineageKey.startsWith(ancestor->lineageKey);
+}
+
+QList<std::shared_ptr<FamilyMember>> FamilyTree::branch(const std::shared_ptr<FamilyMember>& top) const {
+    QList<std::shared_ptr<FamilyMember>> members;
+    if (!top || top->lineageKey.isEmpty()) return members;
+
+    // 以 top 的键为前缀的成员在索引中是一段连续区间
+    for (auto it = lineageIndex.lowerBound(top->lineageKey);
+         it != lineageIndex.constEnd() && it.key().startsWith(top->lineageKey); ++it) {
+        members.append(it.value());
+    }
+    return members;
+}
+
+int FamilyTree::branchSize(const std::shared_ptr<FamilyMember>& top) const {
+    if (!top || top->lineageKey.isEmpty()) return 0;
+
+    int count = 0;
+    for (auto it = lineageIndex.lowerBound(top->lineageKey);
+         it != lineageIndex.constEnd() && it.key().startsWith(top->lineageKey); ++it) {
+        ++count;
+    }
+    return count;
+}
+
+int FamilyTree::depth(const std::shared_ptr<FamilyMember>& member) {
+    if (!member || member->lineageKey.isEmpty()) return -1;
+    return int(member->lineageKey.size() / sizeof(quint32)) - 1;
+}
+
+// 统计单个成员（不含子节点）的内存占用
+static void accumulateMemberBytes(TreeMemoryStats& stats, const FamilyMember& member) {
+    stats.nodeBytes += sizeof(FamilyMember);
+    stats.stringBytes += (member.name.capacity() + member.details.capacity()) * qint64(sizeof(QChar));
+    stats.edgeBytes += (member.children.capacity() + member.spouses.capacity())
+                       * qint64(sizeof(std::shared_ptr<FamilyMember>));
+}
+
+TreeMemoryStats FamilyTree::memoryStats() const {
+    TreeMemoryStats stats;
+    if (!root) return stats;
+
+    // 使用显式栈遍历，避免深层家谱导致递归过深
+    QVector<const FamilyMember*> stack;
+    stack.append(root.get());
+    while (!stack.isEmpty()) {
+        const FamilyMember* node = stack.takeLast();
+        ++stats.memberCount;
+        accumulateMemberBytes(stats, *node);
+        // 世系键本身以及有序索引中的一个结点（键、值与红黑树指针的估算）
+        stats.indexBytes += node->lineageKey.capacity()
+                            + qint64(sizeof(QByteArray) + sizeof(std::shared_ptr<FamilyMember>) + 4 * sizeof(void*));
+
+        // 配偶不在 children 中，单独统计
+        for (const auto& spouse : node->spouses) {
+            ++stats.spouseCount;
+            accumulateMemberBytes(stats, *spouse);
+        }
+        for (const auto& child : node->children) {
+            stack.append(child.get());
+        }
+    }
+    return stats;
+}
+
+bool FamilyTree::addSibling(const QString& targetName, const QString& siblingName, const QString& siblingDetails) {
+    PerfScope perf(PerfOp::AddSibling);
+    // 查找目标节点
+    auto targetNode = findMember(targetName);
+    if (!targetNode) {
+        qCWarning(lcFamilyTreeEdit) << "Target node not found for adding sibling: " << targetName;
+        return false;
+    }
+
+    // 查找父节点
+    auto parentNode = findParent(targetNode);
+    if (!parentNode) {
+        qCWarning(lcFamilyTreeEdit) << "Parent node not found for target: " << targetName;
+        return false;
+    }
+
+    // 创建新的兄弟节点并添加到父节点的子节点列表
+    auto newSibling = std::make_shared<FamilyMember>(siblingName, siblingDetails);
+    attachMember(parentNode, newSibling);
+    qCDebug(lcFamilyTreeEdit) << "Sibling added: " << siblingName << " to parent: " << parentNode->name;
+    return true;
+}
+std::shared_ptr<FamilyMember> FamilyTree::findParent(std::shared_ptr<FamilyMember> targetNode) const {
+    // 根节点和配偶没有父节点
+    if (!targetNode || targetNode->lineageKey.size() <= int(sizeof(quint32))) return nullptr;
+
+    // 去掉最后一层序号即为父节点的世系键
+    return lineageIndex.value(targetNode->lineageKey.chopped(sizeof(quint32)));
+}
+
+// 序列化格式：成员数，随后按先序逐个写出 层级、名称、详细信息、配偶数及每个配偶的名称与详细信息
+void FamilyTree::save(QDataStream& out) const {
+    const auto members = branch(root);
+    out << quint32(members.size());
+    for (const auto& member : members) {
+        out << qint32(depth(member)) << member->name << member->details;
+        out << quint32(member->spouses.size());
+        for (const auto& spouse : member->spouses) {
+            out << spouse->name << spouse->details;
+        }
+    }
+}
+
+bool FamilyTree::load(QDataStream& in) {
+    if (root) return false;
+
+    quint32 count = 0;
+    in >> count;
+
+    // parents[d] 保存最近一个层级为 d 的成员，先序输入保证父节点总在子节点之前
+    QVector<std::shared_ptr<FamilyMember>> parents;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        qint32 level = 0;
+        QString name, details;
+        quint32 spouseCount = 0;
+        in >> level >> name >> details >> spouseCount;
+        if (in.status() != QDataStream::Ok) break;
+        if (level < 0 || level > parents.size() || (level == 0) != (i == 0)) {
+            in.setStatus(QDataStream::ReadCorruptData);
+            break;
+        }
+
+        auto member = std::make_shared<FamilyMember>(name, details);
+        attachMember(level > 0 ? parents[level - 1] : nullptr, member);
+        parents.resize(level + 1);
+        parents[level] = member;
+
+        for (quint32 j = 0; j < spouseCount && in.status() == QDataStream::Ok; ++j) {
+            QString spouseName, spouseDetails;
+            in >> spouseName >> spouseDetails;
+            auto spouse = std::make_shared<FamilyMember>(spouseName, spouseDetails);
+            member->spouses.append(spouse);
+            spouse->spouses.append(member);
+        }
+    }
+    return in.status() == QDataStream::Ok;
+}
@@ -2,39 +2,55 @@
 #define FAMILYTREE_H
 
 #include <QString>
+#include <QVector>
 #include <QList>
+#include <QMap>
+#include <QByteArray>
+#include <QDataStream>
 #include <memory>
+#include "diagnostics.h"
 
+// 定义家庭成员结构体
 struct FamilyMember {
-    QString name;
-    QString details;
-    std::shared_ptr<FamilyMember> spouse;
-    QList<std::shared_ptr<FamilyMember>> children;
-
+    QString name;  // 成员名称
+    QString details;  // 成员详细信息
+    QVector<std::shared_ptr<FamilyMember>> children;  // 子节点列表
+    QVector<std::shared_ptr<FamilyMember>> spouses;  // 配偶列表（支持多个配偶）
+    // 世系键：从根到本节点每一层的子节点序号，每层 4 字节大端编码（Dewey 路径）
+    // 字节序即先序遍历顺序，祖先的键是后代键的前缀；配偶不在树上，键为空
+    QByteArray lineageKey;
+    // 构造函数，用于初始化成员的名称和详细信息
     FamilyMember(const QString& name, const QString& details)
-        : name(name), details(details), spouse(nullptr) {}
+        : name(name), details(details) {}
 };
-
+// 定义家庭树类
 class FamilyTree {
 public:
-    FamilyTree();
-    explicit FamilyTree(const QString& name);
-
-    void addMember(const QString& parentName, const QString& name, const QString& details);
-    void addSpouse(const QString& memberName, const QString& spouseName, const QString& spouseDetails);
-    void addSibling(const QString& targetName, const QString& siblingName, const QString& siblingDetails); // 添加兄弟节点
-    void modifyMember(const QString& name, const QString& newDetails);
-    std::shared_ptr<FamilyMember> findMember(const QString& name);
-
+    FamilyTree();  // 默认构造函数
+    explicit FamilyTree(const QString& name);  // 带参数的构造函数，用于初始化家谱名称
+    bool addMember(const QString& parentName, const QString& name, const QString& details);  // 添加子成员，失败时返回 false
+    bool addSpouse(const QString& memberName, const QString& spouseName, const QString& spouseDetails);  // 添加配偶
+    bool addSibling(const QString& targetName, const QString& siblingName, const QString& siblingDetails);  // 添加兄弟节点
+    bool modifyMember(const QString& name, const QString& newDetails);  // 修改成员信息
+    bool modifySpouseDetails(const QString& memberName, const QString& spouseName, const QString& newDetails);  // 修改配偶信息
+    void removeSpouse(const QString& memberName, const QString& spouseName);  // 移除配偶
+    std::shared_ptr<FamilyMember> findMember(const QString& name);  // 查找成员
+    std::shared_ptr<FamilyMember> getRoot() const { return root; }  // 获取家谱的根节点
+    const QString& getName() const { return treeName; }  // 获取家谱名称
+    TreeMemoryStats memoryStats() const;  // 统计家谱的内存占用
+    bool isDescendant(const std::shared_ptr<FamilyMember>& member, const std::shared_ptr<FamilyMember>& ancestor) const;  // 判断 member 是否为 ancestor 的后代
+    QList<std::shared_ptr<FamilyMember>> branch(const std::shared_ptr<FamilyMember>& top) const;  // 按先序返回以 top 为根的分支
+    int branchSize(const std::shared_ptr<FamilyMember>& top) const;  // 分支成员数（含 top 本身）
+    static int depth(const std::shared_ptr<FamilyMember>& member);  // 成员所在层级，根为 0
+    void save(QDataStream& out) const;  // 按先序写出整棵家谱（含配偶）
+    bool load(QDataStream& in);  // 从 save 的输出重建家谱，仅用于空家谱
 private:
-    std::shared_ptr<FamilyMember> findRecursive(const QString& name, std::shared_ptr<FamilyMember> node);
-    std::shared_ptr<FamilyMember> findParent(std::shared_ptr<FamilyMember> currentNode, std::shared_ptr<FamilyMember> targetNode); // 查找父节点
-
-    QString treeName;
-    std::shared_ptr<FamilyMember> root;
-
-public:
-    std::shared_ptr<FamilyMember> getRoot() const { return root; }
+    QString treeName;  // 家谱名称
+    std::shared_ptr<FamilyMember> root;  // 家谱根节点
+    QMap<QByteArray, std::shared_ptr<FamilyMember>> lineageIndex;  // 按世系键排序的成员索引，分支对应一段连续区间
+    void attachMember(const std::shared_ptr<FamilyMember>& parent, const std::shared_ptr<FamilyMember>& member);  // 挂接成员并维护世系键
+    std::shared_ptr<FamilyMember> findRecursive(const QString& name, std::shared_ptr<FamilyMember> node);  // 递归查找成员
+    std::shared_ptr<FamilyMember> findParent(std::shared_ptr<FamilyMember> targetNode) const;  // 通过世系键查找父节点
 };
 
 #endif // FAMILYTREE_H
@@ -1,9 +1,59 @@
 #include "mainwindow.h"
+#include "treeservice.h"
+#include "treeclient.h"
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QMessageBox>
+
+// 命令行选项：
+//   --serve               以无界面服务模式运行，托管所有家谱
+//   --connect             以瘦客户端模式启动界面，连接到家谱服务
+//   --server-name <name>  本地套接字名称，默认为 familytree
+static const QCommandLineOption serveOption("serve", "以无界面服务模式运行");
+static const QCommandLineOption connectOption("connect", "连接到家谱服务（共享模式）");
+static const QCommandLineOption serverNameOption("server-name", "本地套接字名称", "name", TreeProtocol::DefaultServerName);
+
+static void parseArguments(QCommandLineParser& parser, const QCoreApplication& app) {
+    parser.addHelpOption();
+    parser.addOptions({serveOption, connectOption, serverNameOption});
+    parser.process(app);
+}
+
+// 服务模式不需要创建 QApplication，需在构造应用对象前判断
+static bool isServeMode(int argc, char *argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--serve") == 0) return true;
+    }
+    return false;
+}
 
 int main(int argc, char *argv[]) {
+    if (isServeMode(argc, argv)) {
+        QCoreApplication app(argc, argv);
+        QCommandLineParser parser;
+        parseArguments(parser, app);
+
+        TreeService service;
+        if (!service.listen(parser.value(serverNameOption))) {
+            return 1;
+        }
+        return app.exec();
+    }
+
     QApplication a(argc, argv);
+    QCommandLineParser parser;
+    parseArguments(parser, a);
+
     MainWindow w;
+    if (parser.isSet(connectOption)) {
+        auto client = new TreeClient;
+        if (!client->connectToServer(parser.value(serverNameOption))) {
+            QMessageBox::critical(nullptr, "错误", "无法连接到家谱服务：" + parser.value(serverNameOption));
+            delete client;
+            return 1;
+        }
+        w.attachTreeClient(client);
+    }
     w.show();
     return a.exec();
 }
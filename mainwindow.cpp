@@ -5,150 +5,18 @@
 #include <QFile>
 #include <QTextStream>
 #include <QFileDialog>
-// 默认构造函数，初始化家谱树时设置根节点为空
-FamilyTree::FamilyTree() : root(nullptr) {}
-// 带名称的构造函数，用于创建一个命名的家谱树，并初始化根节点为空
-FamilyTree::FamilyTree(const QString& name) : treeName(name), root(nullptr) {}
-
-// 修改配偶详细信息
-// 输入：成员名称、配偶名称、新的配偶详细信息
-void FamilyTree::modifySpouseDetails(const QString& memberName, const QString& spouseName, const QString& newDetails) {
-    // 查找指定的成员
-    auto member = findMember(memberName);
-    if (member) {
-        // 遍历成员的配偶列表
-        for (auto& spouse : member->spouses) {
-            // 如果找到匹配的配偶，更新其详细信息
-            if (spouse->name == spouseName) {
-                spouse->details = newDetails; // 更新配偶详细信息
-                qDebug() << "成功修改配偶信息: " << spouseName << " -> " << newDetails;
-                return;
-            }
-        }
-        // 如果未找到配偶，输出日志信息
-        qDebug() << "未找到配偶: " << spouseName << " -> 属于成员: " << memberName;
-    } else {
-        // 如果未找到成员，输出日志信息
-        qDebug() << "未找到成员: " << memberName;
-    }
-}
-
-// 添加成员到家谱树
-// 输入：父节点名称（如果为空表示添加根节点）、新成员名称、新成员详细信息
-void FamilyTree::addMember(const QString& parentName, const QString& name, const QString& details) {
-    qDebug() << "Attempting to add member: " << name << " with parent: " << (parentName.isEmpty() ? "ROOT" : parentName);
-
-    // 创建新的家庭成员对象
-    auto newMember = std::make_shared<FamilyMember>(name, details);
-
-    if (parentName.isEmpty()) {
-        // 如果父节点名称为空，检查是否存在根节点
-        if (!root) {
-            // 如果根节点不存在，将新成员设置为根节点
-            root = newMember;
-            qDebug() << "Root member added: " << name;
-        } else {
-            // 如果根节点已存在，输出提示信息
-            qDebug() << "Root member already exists! Current root: " << root->name;
-        }
-    } else {
-        // 查找指定的父节点
-        auto parent = findMember(parentName);
-        if (parent) {
-            // 如果找到父节点，将新成员添加为其子节点
-            parent->children.append(newMember);
-            qDebug() << "Child member added: " << name << " to parent: " << parentName;
-        } else {
-            // 如果未找到父节点，输出提示信息
-            qDebug() << "Parent not found! ParentName: " << parentName;
-            qDebug() << "Check if the parent name matches the root node or other nodes exactly.";
-        }
-    }
-}
-
-void FamilyTree::addSpouse(const QString& memberName, const QString& spouseName, const QString& spouseDetails) {
-    // 查找目标成员
-    auto member = findMember(memberName);
-    if (member) {
-        // 检查配偶列表中是否已经存在该配偶
-        for (const auto& spouse : member->spouses) {
-            if (spouse->name == spouseName) {
-                // 如果配偶已存在，输出提示信息并返回
-                qDebug() << "配偶已存在: " << spouseName;
-                return;
-            }
-        }
-
-        // 创建一个新配偶对象
-        auto newSpouse = std::make_shared<FamilyMember>(spouseName, spouseDetails);
-
-        // 将新配偶添加到成员的配偶列表中
-        member->spouses.append(newSpouse);
-
-        // 建立双向关联：将当前成员添加到新配偶的配偶列表中
-        newSpouse->spouses.append(member);
-
-        // 输出成功添加配偶的信息
-        qDebug() << "成功添加配偶: " << spouseName << " -> " << memberName;
-    } else {
-        // 如果未找到目标成员，输出提示信息
-        qDebug() << "未找到成员: " << memberName;
-    }
-}
-void FamilyTree::modifyMember(const QString& name, const QString& newDetails) {
-    // 调用 findMember 方法查找指定名称的成员
-    auto member = findMember(name);
-    if (member) {
-        // 如果成员找到，更新其详细信息
-        member->details = newDetails;
-        qDebug() << "Successfully updated member details for: " << name;
-    } else {
-        // 如果未找到成员，输出错误信息
-        qDebug() << "Member not found!";
-    }
-}
-
-std::shared_ptr<FamilyMember> FamilyTree::findMember(const QString& name) {
-    // 从根节点开始递归查找成员
-    return findRecursive(name, root);
-}
-
-std::shared_ptr<FamilyMember> FamilyTree::findRecursive(const QString& name, std::shared_ptr<FamilyMember> node) {
-    if (!node) {
-        // 如果当前节点为空，返回 nullptr
-        qDebug() << "Node is null, returning nullptr";
-        return nullptr;
-    }
-
-    // 输出日志信息，显示当前检查的节点
-    qDebug() << "Checking node: " << node->name;
-
-    // 如果找到匹配的节点，返回该节点
-    if (node->name == name) {
-        qDebug() << "Found matching node: " << node->name;
-        return node;
-    }
-
-    // 遍历当前节点的所有子节点
-    for (const auto& child : node->children) {
-        // 输出日志信息，表示正在检查子节点
-        qDebug() << "Descending into child: " << child->name;
-
-        // 递归调用 findRecursive 检查子节点
-        auto found = findRecursive(name, child);
-        if (found) {
-            return found; // 如果找到匹配的节点，则返回
-        }
-    }
-
-    // 如果在当前分支中未找到目标节点，输出日志信息
-    qDebug() << "Node not found in this branch: " << name;
-    return nullptr; // 未找到匹配的节点，返回 nullptr
-}
+#include <QMenuBar>
+#include <QMenu>
+#include <QAction>
+#include <QStatusBar>
+#include <QApplication>
+#include "diagnosticsdock.h"
+#include "treeclient.h"
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::MainWindow),
-    currentFamilyTree(nullptr) // 初始化当前家谱树为 nullptr
+    currentFamilyTree(nullptr), // 初始化当前家谱树为 nullptr
+    treeClient(nullptr) // 默认不连接家谱服务
 {
     ui->setupUi(this); // 设置 UI 组件
 
@@ -162,6 +30,8 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(ui->addSiblingButton, &QPushButton::clicked, this, &MainWindow::onAddSibling);   // 添加兄弟节点按钮
     connect(ui->modifySpouseButton, &QPushButton::clicked, this, &MainWindow::onModifySpouseDetails); // 修改配偶信息按钮
     connect(ui->exportButton, &QPushButton::clicked, this, &MainWindow::exportFamilyTreeToCSV);
+    QMenu* familyTreeMenu = ui->menubar->addMenu("家谱");
+    familyTreeMenu->addAction("导出分支（成员名取自子节点输入框）", this, &MainWindow::exportBranchToCSV);
     // 设置树形组件的样式和列宽
     ui->treeWidget->header()->setSectionResizeMode(QHeaderView::Stretch); // 设置列宽自动调整
     ui->treeWidget->setStyleSheet("background:transparent;"); // 设置背景透明
@@ -173,15 +43,25 @@ MainWindow::MainWindow(QWidget *parent) :
     ui->detailsEdit->setPlaceholderText(QString::fromUtf8("在这里输入性别、信息")); // 详细信息输入框
     ui->familyNameEdit->setPlaceholderText(QString::fromUtf8("请先输入家谱名称")); // 家谱名称输入框
 
+    // 性能诊断面板，默认隐藏，可通过菜单栏打开
+    diagnosticsDock = new DiagnosticsDock(this);
+    diagnosticsDock->setMemoryReportProvider([this]() { return memoryReport(); });
+    addDockWidget(Qt::RightDockWidgetArea, diagnosticsDock);
+    diagnosticsDock->hide();
+    QMenu* diagnosticsMenu = ui->menubar->addMenu("诊断");
+    QAction* toggleDiagnostics = diagnosticsDock->toggleViewAction();
+    toggleDiagnostics->setShortcut(QKeySequence(Qt::Key_F12));
+    diagnosticsMenu->addAction(toggleDiagnostics);
+
     // 双击家谱列表切换家谱
     connect(ui->familyTreeList, &QListWidget::itemDoubleClicked, this, [this](QListWidgetItem* item) {
         QString familyName = item->text(); // 获取双击的家谱名称
         if (familyTrees.contains(familyName)) {
             currentFamilyTree = familyTrees[familyName]; // 切换到指定家谱
-            qDebug() << "Switched to family tree:" << familyName; // 输出日志信息
+            qCDebug(lcFamilyTreeUi) << "Switched to family tree:" << familyName; // 输出日志信息
             refreshTree(); // 刷新当前家谱树
         } else {
-            qDebug() << "Family tree not found!"; // 未找到家谱的提示
+            qCWarning(lcFamilyTreeUi) << "Family tree not found!"; // 未找到家谱的提示
         }
     });
 }
@@ -191,6 +71,132 @@ MainWindow::~MainWindow() {
     qDeleteAll(familyTrees); // 删除所有家谱对象，释放内存
 }
 
+// 作为瘦客户端连接家谱服务：修改操作转发给服务端，本地家谱只是服务端快照的副本
+void MainWindow::attachTreeClient(TreeClient* client) {
+    treeClient = client;
+    treeClient->setParent(this);
+    connect(treeClient, &TreeClient::treeSnapshot, this, &MainWindow::onTreeSnapshot);
+    connect(treeClient, &TreeClient::treeChanged, this, &MainWindow::onTreeChanged);
+    connect(treeClient, &TreeClient::operationFinished, this, &MainWindow::onOperationFinished);
+    connect(treeClient, &TreeClient::serviceStats, diagnosticsDock, &DiagnosticsDock::setServiceReport);
+    connect(diagnosticsDock, &DiagnosticsDock::refreshRequested, treeClient, &TreeClient::requestServiceStats);
+    diagnosticsDock->setServiceReportEnabled(true);
+    connect(treeClient, &TreeClient::disconnected, this, [this]() {
+        diagnosticsDock->setServiceReportEnabled(false);
+        QString message = "与家谱服务的连接已断开，当前显示的数据不会再更新，也不能再修改！";
+        if (!lostOperations.isEmpty()) {
+            message += "\n\n以下修改未得到服务端确认，可能没有保存：\n" + lostOperations.join("\n");
+            lostOperations.clear();
+        }
+        QMessageBox::warning(this, "连接断开", message);
+    });
+    setWindowTitle(windowTitle() + " (共享模式)");
+}
+
+// 共享模式下检查与服务端的连接，断开后拒绝修改
+bool MainWindow::ensureServiceConnected() {
+    if (treeClient && !treeClient->isConnected()) {
+        QMessageBox::warning(this, "错误", "与家谱服务的连接已断开，无法修改，请重新启动程序连接！");
+        return false;
+    }
+    return true;
+}
+
+// 服务端对修改操作的处理结果
+void MainWindow::onOperationFinished(quint32 requestId, const TreeProtocol::Operation& operation, TreeProtocol::Status status) {
+    using TreeProtocol::Status;
+    qCDebug(lcFamilyTreeUi) << "Request" << requestId << TreeProtocol::describe(operation) << int(status);
+
+    if (operation.op == TreeProtocol::Op::CreateTree && status != Status::Ok
+        && operation.args.value(0) == requestedTreeName) {
+        requestedTreeName.clear(); // 创建失败，不再等待切换
+    }
+
+    if (operation.op == TreeProtocol::Op::Snapshot && status == Status::TooLarge) {
+        // 非模态提示：本函数在读取套接字的过程中同步调用，不能在这里阻塞
+        auto box = new QMessageBox(QMessageBox::Warning, "无法同步",
+                                   QString("家谱 %1 超出单次传输上限，无法在共享模式下查看和修改！").arg(operation.args.value(0)),
+                                   QMessageBox::Ok, this);
+        box->setAttribute(Qt::WA_DeleteOnClose);
+        box->open();
+        return;
+    }
+
+    if (!TreeProtocol::isMutation(operation.op)) {
+        if (status != Status::Ok && status != Status::Disconnected) {
+            statusBar()->showMessage(TreeProtocol::describe(operation) + "失败：" + TreeProtocol::statusText(status), 5000);
+        }
+        return;
+    }
+
+    // 结果显示在状态栏而不是弹出对话框：一批修改不会连续弹窗，也不会阻塞后续回复与通知的处理
+    if (status == Status::Disconnected) {
+        lostOperations.append(TreeProtocol::describe(operation)); // 在连接断开的提示中统一列出
+    } else if (status == Status::Ok) {
+        statusBar()->showMessage(TreeProtocol::describe(operation) + " 已完成", 5000);
+    } else {
+        // 失败信息保留到下一条消息出现为止
+        qCWarning(lcFamilyTreeUi) << TreeProtocol::describe(operation) << "failed:" << TreeProtocol::statusText(status);
+        statusBar()->showMessage(TreeProtocol::describe(operation) + " 失败：" + TreeProtocol::statusText(status));
+        QApplication::beep();
+    }
+}
+
+// 在本地副本上按顺序重放服务端已生效的修改，只刷新当前显示的家谱
+void MainWindow::onTreeChanged(const QString& treeName, const QVector<TreeProtocol::Operation>& operations) {
+    FamilyTree* tree = familyTrees.value(treeName, nullptr);
+    bool listChanged = false;
+
+    for (const auto& operation : operations) {
+        if (operation.op == TreeProtocol::Op::CreateTree) {
+            if (!tree) {
+                tree = new FamilyTree(treeName);
+                tree->addMember("", treeName, ""); // 与服务端一致，以家谱名称作为根节点
+                familyTrees.insert(treeName, tree);
+                listChanged = true;
+            }
+            if (treeName == requestedTreeName) {
+                currentFamilyTree = tree; // 切换到刚创建的家谱
+                requestedTreeName.clear();
+            }
+            continue;
+        }
+
+        if (!tree || !TreeProtocol::applyMutation(*tree, operation)) {
+            // 本地副本与服务端不一致，改为拉取快照重新同步
+            qCWarning(lcFamilyTreeUi) << "Replica out of sync, resynchronising" << treeName;
+            treeClient->requestSnapshot(treeName);
+            break;
+        }
+    }
+
+    if (listChanged) {
+        refreshFamilyTreeList();
+    }
+    if (tree && tree == currentFamilyTree) {
+        refreshTree();
+    }
+}
+
+// 用服务端的最新快照替换本地家谱副本
+void MainWindow::onTreeSnapshot(const QString& treeName, FamilyTree* tree) {
+    FamilyTree* oldTree = familyTrees.value(treeName, nullptr);
+    familyTrees[treeName] = tree;
+
+    if ((oldTree && currentFamilyTree == oldTree) || treeName == requestedTreeName) {
+        currentFamilyTree = tree; // 当前家谱或刚创建的家谱切换到新副本
+        requestedTreeName.clear();
+    }
+    delete oldTree;
+
+    if (!oldTree) {
+        refreshFamilyTreeList(); // 新出现的家谱
+    }
+    if (currentFamilyTree == tree) {
+        refreshTree();
+    }
+}
+
 void MainWindow::refreshFamilyTreeList() {
     ui->familyTreeList->clear(); // 清空列表
     for (const auto& familyName : familyTrees.keys()) {
@@ -201,12 +207,18 @@ void MainWindow::refreshFamilyTreeList() {
 void MainWindow::onCreateFamilyTree() {
     QString familyName = ui->familyNameEdit->text().trimmed(); // 去除空格
     if (familyName.isEmpty()) {
-        qDebug() << "Family name cannot be empty!";
+        qCWarning(lcFamilyTreeUi) << "Family name cannot be empty!";
         return;
     }
 
     if (familyTrees.contains(familyName)) {
-        qDebug() << "Family tree already exists!";
+        qCWarning(lcFamilyTreeUi) << "Family tree already exists!";
+    } else if (treeClient) {
+        // 由服务端创建，收到变更通知后再切换过去
+        if (ensureServiceConnected()) {
+            requestedTreeName = familyName;
+            treeClient->createTree(familyName);
+        }
     } else {
         auto newTree = new FamilyTree(familyName);
         familyTrees[familyName] = newTree;
@@ -214,7 +226,7 @@ void MainWindow::onCreateFamilyTree() {
 
         // 添加根节点
         currentFamilyTree->addMember("", familyName, ""); // 默认以家谱名称作为根节点
-        qDebug() << "Created family tree: " << familyName;
+        qCDebug(lcFamilyTreeUi) << "Created family tree: " << familyName;
 
         refreshTree();
         refreshFamilyTreeList(); // 刷新家谱列表
@@ -226,7 +238,7 @@ void MainWindow::onSwitchFamilyTree() {
     QString familyName = ui->familyNameEdit->text();
     if (familyTrees.contains(familyName)) {
         currentFamilyTree = familyTrees[familyName];
-        qDebug() << "Switched to family tree:" << familyName;
+        qCDebug(lcFamilyTreeUi) << "Switched to family tree:" << familyName;
         refreshTree();
 
         // 更新列表中的选中状态
@@ -235,7 +247,7 @@ void MainWindow::onSwitchFamilyTree() {
             ui->familyTreeList->setCurrentItem(items.first());
         }
     } else {
-        qDebug() << "Family tree not found!";
+        qCWarning(lcFamilyTreeUi) << "Family tree not found!";
     }
 }
 
@@ -255,6 +267,14 @@ void MainWindow::onAddMember() {
         return;
     }
 
+    if (treeClient) {
+        // 结果在 onOperationFinished 中提示，树视图在收到变更通知后刷新
+        if (ensureServiceConnected()) {
+            treeClient->addMember(currentFamilyTree->getName(), parentName, name, details);
+        }
+        return;
+    }
+
     currentFamilyTree->addMember(parentName, name, details);
     QMessageBox::information(this, "成功", "成功添加成员：" + name);
     refreshTree(); // 刷新树视图
@@ -279,6 +299,22 @@ void MainWindow::onFindMember() {
         QString info = "找到成员：\n";
         info += "名称：" + member->name + "\n";
         info += "详细信息：" + member->details + "\n";
+        if (FamilyTree::depth(member) >= 0) {
+            info += QString("层级：%1\n").arg(FamilyTree::depth(member));
+            info += QString("后代数量：%1\n").arg(currentFamilyTree->branchSize(member) - 1);
+        }
+
+        // 父节点输入框中填写了成员时，判断所查成员是否为其后代
+        QString ancestorName = ui->parentEdit->text().trimmed();
+        if (!ancestorName.isEmpty()) {
+            auto ancestor = currentFamilyTree->findMember(ancestorName);
+            if (!ancestor) {
+                info += "未找到成员：" + ancestorName + "\n";
+            } else {
+                info += QString("是否为 %1 的后代：%2\n")
+                            .arg(ancestorName, currentFamilyTree->isDescendant(member, ancestor) ? QString("是") : QString("否"));
+            }
+        }
 
         // 遍历配偶列表
         if (!member->spouses.isEmpty()) {
@@ -311,29 +347,29 @@ void MainWindow::onModifyMember() {
         return;
     }
 
-    // 修改当前成员信息
-    auto member = currentFamilyTree->findMember(memberName);
-    if (member) {
-        // 修改成员信息
-        member->details = newDetails;
-        QMessageBox::information(this, "操作成功", QString("成员 %1 信息已修改为: %2").arg(memberName).arg(newDetails));
-    } else {
+    if (treeClient) {
+        // 结果在 onOperationFinished 中提示
+        if (ensureServiceConnected()) {
+            treeClient->modifyMember(currentFamilyTree->getName(), memberName, newDetails);
+            if (!spouseName.isEmpty()) {
+                treeClient->modifySpouseDetails(currentFamilyTree->getName(), memberName, spouseName, newDetails);
+            }
+        }
+        return;
+    }
+
+    // 修改当前成员信息，统一经由家谱接口以便统计耗时
+    if (!currentFamilyTree->modifyMember(memberName, newDetails)) {
         QMessageBox::warning(this, "错误", QString("未找到成员: %1").arg(memberName));
         return;
     }
+    QMessageBox::information(this, "操作成功", QString("成员 %1 信息已修改为: %2").arg(memberName).arg(newDetails));
 
     // 修改配偶信息
     if (!spouseName.isEmpty()) {
-        bool spouseFound = false;
-        for (auto& spouse : member->spouses) {
-            if (spouse->name == spouseName) {
-                spouse->details = newDetails;
-                QMessageBox::information(this, "操作成功", QString("配偶 %1 的信息已修改为: %2").arg(spouseName, newDetails));
-                spouseFound = true;
-                break;
-            }
-        }
-        if (!spouseFound) {
+        if (currentFamilyTree->modifySpouseDetails(memberName, spouseName, newDetails)) {
+            QMessageBox::information(this, "操作成功", QString("配偶 %1 的信息已修改为: %2").arg(spouseName, newDetails));
+        } else {
             QMessageBox::warning(this, "错误", QString("成员 %1 的配偶中未找到: %2").arg(memberName, spouseName));
         }
     }
@@ -398,6 +434,14 @@ void MainWindow::onAddSpouse() {
         return;
     }
 
+    if (treeClient) {
+        // 结果在 onOperationFinished 中提示
+        if (ensureServiceConnected()) {
+            treeClient->addSpouse(currentFamilyTree->getName(), memberName, spouseName, spouseDetails);
+        }
+        return;
+    }
+
     currentFamilyTree->addSpouse(memberName, spouseName, spouseDetails);
     QMessageBox::information(this, "操作成功", QString("成功为成员 %1 添加配偶 %2").arg(memberName, spouseName));
 
@@ -407,52 +451,19 @@ void MainWindow::onAddSpouse() {
 
 
 void MainWindow::refreshTree() {
+    PerfScope perf(PerfOp::RefreshTree);
     ui->treeWidget->clear(); // 清空树视图
     if (currentFamilyTree && currentFamilyTree->getRoot()) {
-        qDebug() << "Refreshing tree from root: " << currentFamilyTree->getRoot()->name;
+        qCDebug(lcFamilyTreeUi) << "Refreshing tree from root: " << currentFamilyTree->getRoot()->name;
         addTreeNode(nullptr, currentFamilyTree->getRoot()); // 从根节点开始递归添加
     } else {
-        qDebug() << "No root node to refresh!";
-    }
-}
-
-void FamilyTree::addSibling(const QString& targetName, const QString& siblingName, const QString& siblingDetails) {
-    // 查找目标节点
-    auto targetNode = findMember(targetName);
-    if (!targetNode) {
-        qDebug() << "Target node not found for adding sibling: " << targetName;
-        return;
+        qCWarning(lcFamilyTreeUi) << "No root node to refresh!";
     }
-
-    // 查找父节点
-    auto parentNode = findParent(root, targetNode);
-    if (!parentNode) {
-        qDebug() << "Parent node not found for target: " << targetName;
-        return;
-    }
-
-    // 创建新的兄弟节点并添加到父节点的子节点列表
-    auto newSibling = std::make_shared<FamilyMember>(siblingName, siblingDetails);
-    parentNode->children.append(newSibling);
-    qDebug() << "Sibling added: " << siblingName << " to parent: " << parentNode->name;
 }
-std::shared_ptr<FamilyMember> FamilyTree::findParent(std::shared_ptr<FamilyMember> currentNode, std::shared_ptr<FamilyMember> targetNode) {
-    if (!currentNode) return nullptr;
 
-    // 遍历当前节点的所有子节点，检查是否包含目标节点
-    for (const auto& child : currentNode->children) {
-        if (child == targetNode) {
-            return currentNode; // 找到父节点
-        }
-        // 递归检查子节点
-        auto parent = findParent(child, targetNode);
-        if (parent) return parent;
-    }
-    return nullptr;
-}
 void MainWindow::onAddSibling() {
     if (!currentFamilyTree) {
-        qDebug() << "No family tree selected!";
+        qCWarning(lcFamilyTreeUi) << "No family tree selected!";
         QMessageBox::warning(this, "错误", "尚未选择家谱！");
         return;
     }
@@ -466,7 +477,15 @@ void MainWindow::onAddSibling() {
         return;
     }
 
-    qDebug() << "Adding sibling: TargetName: " << targetName << ", SiblingName: " << siblingName;
+    qCDebug(lcFamilyTreeUi) << "Adding sibling: TargetName: " << targetName << ", SiblingName: " << siblingName;
+
+    if (treeClient) {
+        // 结果在 onOperationFinished 中提示
+        if (ensureServiceConnected()) {
+            treeClient->addSibling(currentFamilyTree->getName(), targetName, siblingName, siblingDetails);
+        }
+        return;
+    }
 
     try {
         // 调用家谱树方法添加兄弟节点
@@ -477,7 +496,7 @@ void MainWindow::onAddSibling() {
         refreshTree(); // 刷新家谱树视图
     } catch (const std::exception &e) {
         QMessageBox::critical(this, "操作失败", QString("兄弟节点添加失败: %1").arg(e.what()));
-        qDebug() << "Exception: " << e.what();
+        qCWarning(lcFamilyTreeUi) << "Exception: " << e.what();
     }
 }
 void MainWindow::modifySpouseDetails(const QString& memberName, const QString& spouseName, const QString& newDetails) {
@@ -525,6 +544,14 @@ void MainWindow::onModifySpouseDetails() {
         return;
     }
 
+    if (treeClient) {
+        // 结果在 onOperationFinished 中提示
+        if (ensureServiceConnected()) {
+            treeClient->modifySpouseDetails(currentFamilyTree->getName(), memberName, spouseName, newDetails);
+        }
+        return;
+    }
+
     currentFamilyTree->modifySpouseDetails(memberName, spouseName, newDetails);
 
     QMessageBox::information(this, "操作成功", QString("成功修改成员 %1 的配偶 %2 的信息为: %3")
@@ -539,7 +566,34 @@ void MainWindow::exportFamilyTreeToCSV() {
         return;
     }
 
-    QString fileName = QFileDialog::getSaveFileName(this, "导出家庭树", "", "CSV 文件 (*.csv)");
+    writeBranchToCSV(currentFamilyTree->getRoot(), "导出家庭树");
+}
+
+// 导出子节点输入框中指定成员的分支
+void MainWindow::exportBranchToCSV() {
+    if (!currentFamilyTree) {
+        QMessageBox::warning(this, "错误", "尚未选择家谱！");
+        return;
+    }
+
+    QString name = ui->nameEdit->text().trimmed();
+    if (name.isEmpty()) {
+        QMessageBox::warning(this, "输入错误", "请输入要导出分支的成员名称！");
+        return;
+    }
+
+    auto member = currentFamilyTree->findMember(name);
+    if (!member) {
+        QMessageBox::warning(this, "未找到", "未找到成员：" + name);
+        return;
+    }
+
+    writeBranchToCSV(member, "导出分支");
+}
+
+// 选择文件并按先序写入以 top 为根的分支
+void MainWindow::writeBranchToCSV(std::shared_ptr<FamilyMember> top, const QString& title) {
+    QString fileName = QFileDialog::getSaveFileName(this, title, "", "CSV 文件 (*.csv)");
     if (fileName.isEmpty()) {
         return; // 用户取消操作
     }
@@ -550,22 +604,23 @@ void MainWindow::exportFamilyTreeToCSV() {
         return;
     }
 
+    PerfScope perf(PerfOp::ExportCsv); // 只统计写文件的耗时，不含对话框
+
     QTextStream out(&file);
 
     // 写入 CSV 文件头
     out << "成员名称,详细信息,配偶信息,层级" << Qt::endl;
 
-    // 从根节点递归写入数据
-    auto root = currentFamilyTree->getRoot();
-    if (root) {
-        writeNodeToCSV(out, root, 0);
+    // 分支在世系索引中是连续区间，直接按先序写出，层级由世系键长度得到
+    for (const auto& node : currentFamilyTree->branch(top)) {
+        writeNodeToCSV(out, node, FamilyTree::depth(node));
     }
 
     file.close();
     QMessageBox::information(this, "导出成功", "家庭树已成功导出到：" + fileName);
 }
 
-// 递归写入节点及其子节点
+// 写入单个节点
 void MainWindow::writeNodeToCSV(QTextStream& out, std::shared_ptr<FamilyMember> node, int level) {
     if (!node) return;
 
@@ -583,9 +638,34 @@ void MainWindow::writeNodeToCSV(QTextStream& out, std::shared_ptr<FamilyMember>
 
     // 写入 CSV 行
     out << node->name << "," << node->details << "," << spousesInfo << "," << level << Qt::endl;
+}
 
-    // 递归写入子节点
-    for (const auto& child : node->children) {
-        writeNodeToCSV(out, child, level + 1);
-    }
+// 生成每个家谱的内存占用报告，需要遍历全部成员，只在诊断面板显式刷新时调用
+QString MainWindow::memoryReport() const {
+    QString report;
+    TreeMemoryStats total;
+    for (auto it = familyTrees.constBegin(); it != familyTrees.constEnd(); ++it) {
+        const TreeMemoryStats stats = it.value()->memoryStats();
+        report += QString("%1: 成员 %2, 配偶 %3, 节点 %4 B, 字符串 %5 B, 边 %6 B, 索引 %7 B, 合计 %8 B\n")
+                      .arg(it.key())
+                      .arg(stats.memberCount)
+                      .arg(stats.spouseCount)
+                      .arg(stats.nodeBytes)
+                      .arg(stats.stringBytes)
+                      .arg(stats.edgeBytes)
+                      .arg(stats.indexBytes)
+                      .arg(stats.totalBytes());
+        total.memberCount += stats.memberCount;
+        total.spouseCount += stats.spouseCount;
+        total.nodeBytes += stats.nodeBytes;
+        total.stringBytes += stats.stringBytes;
+        total.edgeBytes += stats.edgeBytes;
+        total.indexBytes += stats.indexBytes;
+    }
+    report += QString("共 %1 个家谱, 成员 %2, 配偶 %3, 合计 %4 B\n")
+                  .arg(familyTrees.size())
+                  .arg(total.memberCount)
+                  .arg(total.spouseCount)
+                  .arg(total.totalBytes());
+    return report;
 }
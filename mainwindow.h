@@ -9,36 +9,11 @@
 #include <QListWidget>
 #include <memory>
 #include <QVector>
+#include "familytree.h"
+#include "treeprotocol.h"
 
-// 定义家庭成员结构体
-struct FamilyMember {
-    QString name;  // 成员名称
-    QString details;  // 成员详细信息
-    QVector<std::shared_ptr<FamilyMember>> children;  // 子节点列表
-    QVector<std::shared_ptr<FamilyMember>> spouses;  // 配偶列表（支持多个配偶）
-    // 构造函数，用于初始化成员的名称和详细信息
-    FamilyMember(const QString& name, const QString& details)
-        : name(name), details(details) {}
-};
-// 定义家庭树类
-class FamilyTree {
-public:
-    FamilyTree();  // 默认构造函数
-    explicit FamilyTree(const QString& name);  // 带参数的构造函数，用于初始化家谱名称
-    void addMember(const QString& parentName, const QString& name, const QString& details);  // 添加子成员
-    void addSpouse(const QString& memberName, const QString& spouseName, const QString& spouseDetails);  // 添加配偶
-    void addSibling(const QString& targetName, const QString& siblingName, const QString& siblingDetails);  // 添加兄弟节点
-    void modifyMember(const QString& name, const QString& newDetails);  // 修改成员信息
-    void modifySpouseDetails(const QString& memberName, const QString& spouseName, const QString& newDetails);  // 修改配偶信息
-    void removeSpouse(const QString& memberName, const QString& spouseName);  // 移除配偶
-    std::shared_ptr<FamilyMember> findMember(const QString& name);  // 查找成员
-    std::shared_ptr<FamilyMember> getRoot() const { return root; }  // 获取家谱的根节点
-private:
-    QString treeName;  // 家谱名称
-    std::shared_ptr<FamilyMember> root;  // 家谱根节点
-    std::shared_ptr<FamilyMember> findRecursive(const QString& name, std::shared_ptr<FamilyMember> node);  // 递归查找成员
-    std::shared_ptr<FamilyMember> findParent(std::shared_ptr<FamilyMember> currentNode, std::shared_ptr<FamilyMember> targetNode);  // 查找父节点
-};
+class DiagnosticsDock;
+class TreeClient;
 
 // 定义主窗口类
 namespace Ui {
@@ -51,6 +26,7 @@ class MainWindow : public QMainWindow {
 public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
+    void attachTreeClient(TreeClient* client);  // 切换为家谱服务的瘦客户端，窗口接管 client 的所有权
 
 private slots:
     void onAddMember();  // 添加成员按钮的槽函数
@@ -66,12 +42,23 @@ private slots:
     void modifySpouseDetails(const QString& memberName, const QString& spouseName, const QString& newDetails);  // 修改配偶信息
     void onModifySpouseDetails();  // 修改配偶信息按钮的槽函数
     void exportFamilyTreeToCSV();
+    void exportBranchToCSV();  // 导出指定成员的分支
+    void onTreeSnapshot(const QString& treeName, FamilyTree* tree);  // 收到服务端的家谱快照
+    void onTreeChanged(const QString& treeName, const QVector<TreeProtocol::Operation>& operations);  // 重放服务端推送的修改
+    void onOperationFinished(quint32 requestId, const TreeProtocol::Operation& operation, TreeProtocol::Status status);  // 提示修改操作的结果
 private:
     Ui::MainWindow *ui;  // UI 界面指针
     QMap<QString, FamilyTree*> familyTrees;  // 家谱映射，保存多个家谱
     FamilyTree* currentFamilyTree;  // 当前选中的家谱
+    TreeClient* treeClient;  // 非空时为瘦客户端模式，修改操作转发给家谱服务
+    QString requestedTreeName;  // 瘦客户端模式下刚请求创建、等待通知的家谱
+    QStringList lostOperations;  // 连接断开时尚未得到确认的修改
+    bool ensureServiceConnected();  // 共享模式下连接已断开时提示并返回 false
     void addTreeNode(QTreeWidgetItem* parent, std::shared_ptr<FamilyMember> node);  // 添加树节点到界面
     void writeNodeToCSV(QTextStream& out, std::shared_ptr<FamilyMember> node, int level);
+    void writeBranchToCSV(std::shared_ptr<FamilyMember> top, const QString& title);  // 选择文件并导出分支
+    DiagnosticsDock* diagnosticsDock;  // 性能诊断面板
+    QString memoryReport() const;  // 生成各家谱的内存占用报告
 };
 
 #endif // MAINWINDOW_H
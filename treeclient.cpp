@@ -0,0 +1,300 @@
+#include "treeclient.h"
+#include <QLocalSocket>
+#include <QDataStream>
+#include <QStringList>
+#include <QTimer>
+#include <QDebug>
+
+using TreeProtocol::FrameType;
+using TreeProtocol::Op;
+using TreeProtocol::Status;
+
+// 请求帧头部（帧类型、请求号、操作数）预留的字节数
+static constexpr qsizetype RequestHeaderSize = 16;
+
+TreeClient::TreeClient(QObject *parent) :
+    QObject(parent),
+    socket(new QLocalSocket(this)),
+    nextRequestId(1),
+    flushScheduled(false)
+{
+    connect(socket, &QLocalSocket::readyRead, this, &TreeClient::onReadyRead);
+    connect(socket, &QLocalSocket::disconnected, this, &TreeClient::onDisconnected);
+}
+
+bool TreeClient::connectToServer(const QString& serverName, int timeoutMs) {
+    socket->connectToServer(serverName);
+    if (!socket->waitForConnected(timeoutMs)) {
+        qCWarning(lcFamilyTreeService) << "Failed to connect to" << serverName << ":" << socket->errorString();
+        return false;
+    }
+
+    // 先订阅再列出家谱，保证不会漏掉两者之间发生的修改
+    enqueue({Op::Subscribe, {}});
+    enqueue({Op::ListTrees, {}});
+    flush();
+    return true;
+}
+
+bool TreeClient::isConnected() const {
+    return socket->state() == QLocalSocket::ConnectedState;
+}
+
+quint32 TreeClient::createTree(const QString& treeName) {
+    return enqueue({Op::CreateTree, {treeName}});
+}
+
+quint32 TreeClient::addMember(const QString& treeName, const QString& parentName, const QString& name, const QString& details) {
+    return enqueue({Op::AddMember, {treeName, parentName, name, details}});
+}
+
+quint32 TreeClient::addSpouse(const QString& treeName, const QString& memberName, const QString& spouseName, const QString& spouseDetails) {
+    return enqueue({Op::AddSpouse, {treeName, memberName, spouseName, spouseDetails}});
+}
+
+quint32 TreeClient::addSibling(const QString& treeName, const QString& targetName, const QString& siblingName, const QString& siblingDetails) {
+    return enqueue({Op::AddSibling, {treeName, targetName, siblingName, siblingDetails}});
+}
+
+quint32 TreeClient::modifyMember(const QString& treeName, const QString& name, const QString& newDetails) {
+    return enqueue({Op::ModifyMember, {treeName, name, newDetails}});
+}
+
+quint32 TreeClient::modifySpouseDetails(const QString& treeName, const QString& memberName, const QString& spouseName, const QString& newDetails) {
+    return enqueue({Op::ModifySpouse, {treeName, memberName, spouseName, newDetails}});
+}
+
+void TreeClient::requestSnapshot(const QString& treeName) {
+    // 快照已在等待中时无需重复请求：它会在服务端执行到时反映最新状态；
+    // 已知过大的快照每次都会被拒绝，不再让服务端重复序列化
+    if (awaitingSnapshots.contains(treeName) || unsyncableTrees.contains(treeName)) return;
+    awaitingSnapshots.insert(treeName);
+    pendingSnapshots.insert(treeName);
+    scheduleFlush();
+}
+
+void TreeClient::requestServiceStats() {
+    enqueue({Op::ServiceStats, {}});
+}
+
+quint32 TreeClient::enqueue(const TreeProtocol::Operation& operation) {
+    if (!isConnected()) {
+        emit operationFinished(0, operation, Status::Disconnected);
+        return 0;
+    }
+
+    QByteArray encoded;
+    QDataStream out(&encoded, QIODevice::WriteOnly);
+    out.setVersion(TreeProtocol::StreamVersion);
+    TreeProtocol::writeOperation(out, operation);
+
+    // 单个操作本身放不进一帧时直接拒绝，否则服务端会因帧过大断开连接
+    if (RequestHeaderSize + encoded.size() > qsizetype(TreeProtocol::MaxFrameSize)) {
+        emit operationFinished(0, operation, Status::TooLarge);
+        return 0;
+    }
+
+    // 一个请求帧最多容纳 quint16 个操作，且总字节数不超过单帧上限
+    if (pendingOperations.size() >= 0xFFFF
+        || RequestHeaderSize + pendingOps.size() + encoded.size() > qsizetype(TreeProtocol::MaxFrameSize)) {
+        flush();
+    }
+
+    pendingOps.append(encoded);
+    pendingOperations.append(operation);
+    scheduleFlush();
+    return nextRequestId; // 当前批次发出时使用的请求号
+}
+
+void TreeClient::scheduleFlush() {
+    if (flushScheduled) return;
+    flushScheduled = true;
+    QTimer::singleShot(0, this, &TreeClient::flush);
+}
+
+void TreeClient::sendRequest(const QVector<TreeProtocol::Operation>& operations, const QByteArray& encodedOps) {
+    const quint32 requestId = nextRequestId++;
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(TreeProtocol::StreamVersion);
+    out << quint8(FrameType::Request) << requestId << quint16(operations.size());
+    payload.append(encodedOps);
+
+    // 不等待之前请求的回复，服务端会按顺序逐帧处理
+    socket->write(TreeProtocol::frame(payload));
+    inFlight.insert(requestId, operations);
+}
+
+void TreeClient::flush() {
+    flushScheduled = false;
+    if (!isConnected()) return; // 未发出的操作由 onDisconnected 报告失败
+
+    if (!pendingOperations.isEmpty()) {
+        sendRequest(pendingOperations, pendingOps);
+        pendingOps.clear();
+        pendingOperations.clear();
+    }
+
+    // 每个快照单独成帧，避免多个家谱的快照挤进同一个回复帧
+    for (const auto& treeName : std::as_const(pendingSnapshots)) {
+        const TreeProtocol::Operation operation{Op::Snapshot, {treeName}};
+        QByteArray encoded;
+        QDataStream out(&encoded, QIODevice::WriteOnly);
+        out.setVersion(TreeProtocol::StreamVersion);
+        TreeProtocol::writeOperation(out, operation);
+        sendRequest({operation}, encoded);
+    }
+    pendingSnapshots.clear();
+}
+
+void TreeClient::onDisconnected() {
+    for (auto it = inFlight.constBegin(); it != inFlight.constEnd(); ++it) {
+        for (const auto& operation : it.value()) {
+            emit operationFinished(it.key(), operation, Status::Disconnected);
+        }
+    }
+    for (const auto& operation : std::as_const(pendingOperations)) {
+        emit operationFinished(nextRequestId, operation, Status::Disconnected);
+    }
+    inFlight.clear();
+    pendingOps.clear();
+    pendingOperations.clear();
+    pendingSnapshots.clear();
+    awaitingSnapshots.clear();
+    treeSequences.clear();
+    unsyncableTrees.clear();
+    emit disconnected();
+}
+
+void TreeClient::onReadyRead() {
+    // 处理期间到达的数据不会再次触发 readyRead，因此一直读到没有剩余数据为止
+    while (socket->bytesAvailable() > 0) {
+        readBuffer.append(socket->readAll());
+        if (!processFrames()) {
+            qCWarning(lcFamilyTreeService) << "Protocol error, closing connection";
+            socket->abort();
+            return;
+        }
+    }
+}
+
+bool TreeClient::processFrames() {
+    qsizetype offset = 0;
+    QByteArray payload;
+    bool protocolError = false;
+    while (TreeProtocol::takeFrame(readBuffer, offset, payload, protocolError)) {
+        QDataStream in(payload);
+        in.setVersion(TreeProtocol::StreamVersion);
+        quint8 type = 0;
+        in >> type;
+
+        const bool handled = type == quint8(FrameType::Reply) ? handleReply(in)
+                             : type == quint8(FrameType::Notify) ? handleNotify(in)
+                             : false;
+        if (!handled) {
+            protocolError = true;
+            break;
+        }
+    }
+    readBuffer.remove(0, offset);
+    return !protocolError;
+}
+
+bool TreeClient::handleReply(QDataStream& in) {
+    quint32 requestId = 0;
+    quint16 count = 0;
+    in >> requestId >> count;
+    const QVector<TreeProtocol::Operation> operations = inFlight.take(requestId);
+    if (in.status() != QDataStream::Ok || operations.size() != count) {
+        return false;
+    }
+
+    for (const auto& operation : operations) {
+        quint8 code = 0;
+        in >> code;
+        if (in.status() != QDataStream::Ok) return false;
+        const Status status = static_cast<Status>(code);
+
+        if (operation.op == Op::Snapshot) {
+            awaitingSnapshots.remove(operation.args.value(0));
+            if (status == Status::TooLarge) {
+                unsyncableTrees.insert(operation.args.value(0));
+                qCWarning(lcFamilyTreeService) << "Snapshot too large, giving up on" << operation.args.value(0);
+            }
+        }
+
+        // 失败的结果不附带数据，可以继续解析后续结果
+        if (status == Status::Ok) {
+            switch (operation.op) {
+            case Op::ListTrees: {
+                QStringList treeNames;
+                in >> treeNames;
+                for (const auto& treeName : std::as_const(treeNames)) {
+                    requestSnapshot(treeName);
+                }
+                break;
+            }
+            case Op::Snapshot: {
+                QString treeName;
+                quint64 sequence = 0;
+                in >> treeName >> sequence;
+                auto tree = new FamilyTree(treeName);
+                if (!tree->load(in)) {
+                    delete tree;
+                    return false;
+                }
+                treeSequences.insert(treeName, sequence);
+                emit treeSnapshot(treeName, tree);
+                break;
+            }
+            case Op::ServiceStats: {
+                QString report;
+                in >> report;
+                emit serviceStats(report);
+                break;
+            }
+            default:
+                break;
+            }
+            if (in.status() != QDataStream::Ok) return false;
+        }
+        emit operationFinished(requestId, operation, status);
+    }
+    return true;
+}
+
+bool TreeClient::handleNotify(QDataStream& in) {
+    QString treeName;
+    quint64 firstSequence = 0;
+    quint16 count = 0;
+    in >> treeName >> firstSequence >> count;
+    if (in.status() != QDataStream::Ok) return false;
+
+    QVector<TreeProtocol::Operation> operations;
+    operations.reserve(count);
+    for (quint16 i = 0; i < count; ++i) {
+        TreeProtocol::Operation operation;
+        if (!TreeProtocol::readOperation(in, operation)) return false;
+        operations.append(operation);
+    }
+
+    // 等待中的快照在服务端执行时已包含这些修改，不能再重放一次
+    if (count == 0 || awaitingSnapshots.contains(treeName) || unsyncableTrees.contains(treeName)) {
+        return true;
+    }
+
+    // 丢弃本地副本已包含的修改（快照之后才到达的同批通知）；出现缺口说明漏掉了修改，重新同步
+    const quint64 known = treeSequences.value(treeName);
+    if (firstSequence > known + 1) {
+        qCWarning(lcFamilyTreeService) << "Missed changes, resynchronising" << treeName;
+        requestSnapshot(treeName);
+        return true;
+    }
+    const qsizetype skip = qsizetype(known + 1 - firstSequence);
+    if (skip >= operations.size()) {
+        return true;
+    }
+    treeSequences.insert(treeName, firstSequence + count - 1);
+    emit treeChanged(treeName, operations.mid(skip));
+    return true;
+}
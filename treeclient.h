@@ -0,0 +1,68 @@
+#ifndef TREECLIENT_H
+#define TREECLIENT_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <QByteArray>
+#include "familytree.h"
+#include "treeprotocol.h"
+
+class QLocalSocket;
+
+// 家谱服务的客户端：把修改操作转发给服务端，并把服务端推送的修改交给界面在本地副本上重放
+// 同一轮事件循环内发出的操作合并为一个请求帧，且不等待前一个请求的回复
+class TreeClient : public QObject {
+    Q_OBJECT
+
+public:
+    explicit TreeClient(QObject *parent = nullptr);
+
+    bool connectToServer(const QString& serverName, int timeoutMs = 3000);  // 连接服务端并订阅变更
+    bool isConnected() const;  // 断开后不再接受修改操作
+
+    // 以下修改操作返回请求号，结果通过 operationFinished 报告
+    quint32 createTree(const QString& treeName);
+    quint32 addMember(const QString& treeName, const QString& parentName, const QString& name, const QString& details);
+    quint32 addSpouse(const QString& treeName, const QString& memberName, const QString& spouseName, const QString& spouseDetails);
+    quint32 addSibling(const QString& treeName, const QString& targetName, const QString& siblingName, const QString& siblingDetails);
+    quint32 modifyMember(const QString& treeName, const QString& name, const QString& newDetails);
+    quint32 modifySpouseDetails(const QString& treeName, const QString& memberName, const QString& spouseName, const QString& newDetails);
+    void requestSnapshot(const QString& treeName);  // 请求家谱快照，用于首次同步或本地副本失步后的重新同步
+    void requestServiceStats();  // 请求服务端的性能统计
+
+signals:
+    void operationFinished(quint32 requestId, const TreeProtocol::Operation& operation, TreeProtocol::Status status);  // 服务端对某个操作的处理结果
+    void treeSnapshot(const QString& treeName, FamilyTree* tree);  // 收到家谱快照，接收方取得 tree 的所有权
+    void treeChanged(const QString& treeName, const QVector<TreeProtocol::Operation>& operations);  // 服务端上已生效的修改，需按顺序重放
+    void serviceStats(const QString& report);  // 收到服务端的性能统计
+    void disconnected();  // 与服务端的连接断开
+
+private slots:
+    void flush();  // 把待发送的操作打包为请求帧发出
+    void onReadyRead();  // 读取并处理回复与通知，直到没有剩余数据
+    void onDisconnected();  // 未完成的操作全部以 Disconnected 结束
+
+private:
+    quint32 enqueue(const TreeProtocol::Operation& operation);
+    void scheduleFlush();
+    void sendRequest(const QVector<TreeProtocol::Operation>& operations, const QByteArray& encodedOps);
+    bool processFrames();  // 处理 readBuffer 中所有完整的帧，协议错误时返回 false
+    bool handleReply(QDataStream& in);
+    bool handleNotify(QDataStream& in);
+
+    QLocalSocket* socket;
+    QByteArray readBuffer;  // 尚未处理完的输入数据
+    QByteArray pendingOps;  // 当前批次已编码的操作
+    QVector<TreeProtocol::Operation> pendingOperations;  // 当前批次的操作，用于报告结果
+    QSet<QString> pendingSnapshots;  // 待请求快照的家谱，每个快照单独成帧
+    QSet<QString> awaitingSnapshots;  // 已请求、尚未收到快照的家谱，期间的变更通知由快照覆盖
+    QHash<quint32, QVector<TreeProtocol::Operation>> inFlight;  // 已发出、尚未收到回复的请求
+    QHash<QString, quint64> treeSequences;  // 本地副本已包含的最后一个修改序号
+    QSet<QString> unsyncableTrees;  // 快照过大的家谱，不再请求快照也不再转发其通知
+    quint32 nextRequestId;
+    bool flushScheduled;
+};
+
+#endif // TREECLIENT_H
@@ -0,0 +1,125 @@
+#include "treeprotocol.h"
+#include "familytree.h"
+#include <QtEndian>
+
+namespace TreeProtocol {
+
+int argumentCount(Op op) {
+    switch (op) {
+    case Op::ListTrees: return 0;
+    case Op::CreateTree: return 1;
+    case Op::AddMember: return 4;
+    case Op::AddSpouse: return 4;
+    case Op::AddSibling: return 4;
+    case Op::ModifyMember: return 3;
+    case Op::ModifySpouse: return 4;
+    case Op::Snapshot: return 1;
+    case Op::Subscribe: return 0;
+    case Op::ServiceStats: return 0;
+    }
+    return -1;
+}
+
+bool isMutation(Op op) {
+    switch (op) {
+    case Op::CreateTree:
+    case Op::AddMember:
+    case Op::AddSpouse:
+    case Op::AddSibling:
+    case Op::ModifyMember:
+    case Op::ModifySpouse:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void writeOperation(QDataStream& out, const Operation& operation) {
+    out << quint8(operation.op);
+    for (const auto& arg : operation.args) {
+        out << arg;
+    }
+}
+
+bool readOperation(QDataStream& in, Operation& operation) {
+    quint8 code = 0;
+    in >> code;
+    operation.op = static_cast<Op>(code);
+    const int argc = argumentCount(operation.op);
+    if (in.status() != QDataStream::Ok || argc < 0) return false;
+
+    operation.args.clear();
+    for (int i = 0; i < argc; ++i) {
+        QString arg;
+        in >> arg;
+        operation.args.append(arg);
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+bool applyMutation(FamilyTree& tree, const Operation& operation) {
+    const QStringList& args = operation.args;
+    switch (operation.op) {
+    case Op::AddMember: return tree.addMember(args[1], args[2], args[3]);
+    case Op::AddSpouse: return tree.addSpouse(args[1], args[2], args[3]);
+    case Op::AddSibling: return tree.addSibling(args[1], args[2], args[3]);
+    case Op::ModifyMember: return tree.modifyMember(args[1], args[2]);
+    case Op::ModifySpouse: return tree.modifySpouseDetails(args[1], args[2], args[3]);
+    default: return false;
+    }
+}
+
+QString statusText(Status status) {
+    switch (status) {
+    case Status::Ok: return "成功";
+    case Status::NotFound: return "家谱不存在";
+    case Status::Rejected: return "操作未生效（成员不存在，或家谱、配偶、根节点已存在）";
+    case Status::BadRequest: return "服务端无法识别该请求";
+    case Status::TooLarge: return "数据超出单次传输上限";
+    case Status::Disconnected: return "与家谱服务的连接已断开";
+    }
+    return "未知错误";
+}
+
+QString describe(const Operation& operation) {
+    const QStringList& args = operation.args;
+    switch (operation.op) {
+    case Op::ListTrees: return "获取家谱列表";
+    case Op::CreateTree: return QString("创建家谱 %1").arg(args.value(0));
+    case Op::AddMember: return QString("为 %1 添加成员 %2").arg(args.value(1), args.value(2));
+    case Op::AddSpouse: return QString("为成员 %1 添加配偶 %2").arg(args.value(1), args.value(2));
+    case Op::AddSibling: return QString("为 %1 添加兄弟节点 %2").arg(args.value(1), args.value(2));
+    case Op::ModifyMember: return QString("修改成员 %1 的信息").arg(args.value(1));
+    case Op::ModifySpouse: return QString("修改成员 %1 的配偶 %2 的信息").arg(args.value(1), args.value(2));
+    case Op::Snapshot: return QString("同步家谱 %1").arg(args.value(0));
+    case Op::Subscribe: return "订阅变更通知";
+    case Op::ServiceStats: return "获取服务端性能统计";
+    }
+    return "未知操作";
+}
+
+QByteArray frame(const QByteArray& payload) {
+    QByteArray data(sizeof(quint32), Qt::Uninitialized);
+    qToBigEndian(quint32(payload.size()), data.data());
+    data.append(payload);
+    return data;
+}
+
+bool takeFrame(const QByteArray& buffer, qsizetype& offset, QByteArray& payload, bool& error) {
+    error = false;
+    const qsizetype available = buffer.size() - offset;
+    if (available < qsizetype(sizeof(quint32))) return false;
+
+    const quint32 length = qFromBigEndian<quint32>(buffer.constData() + offset);
+    if (length > MaxFrameSize) {
+        error = true;
+        return false;
+    }
+    if (available - qsizetype(sizeof(quint32)) < qsizetype(length)) return false;
+
+    payload = buffer.mid(offset + sizeof(quint32), length);
+    offset += sizeof(quint32) + length;
+    return true;
+}
+
+}
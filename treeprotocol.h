@@ -0,0 +1,79 @@
+#ifndef TREEPROTOCOL_H
+#define TREEPROTOCOL_H
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QString>
+#include <QStringList>
+
+class FamilyTree;
+
+// 家谱服务的二进制协议
+//
+// 每个帧为 4 字节大端长度 + 负载，负载用 QDataStream 编码，首字节为帧类型：
+//   Request: quint32 请求号, quint16 操作数, 随后每个操作为 quint8 操作码 + 参数
+//   Reply:   quint32 请求号, quint16 结果数, 随后每个结果为 quint8 状态 + 返回数据（仅状态为 Ok 时）
+//   Notify:  QString 家谱名称, quint64 首个操作的序号, quint16 操作数, 随后为已在服务端生效的修改操作（编码同 Request）
+// 服务端为每棵家谱的修改依次编号（CreateTree 为 1），快照中带有它已包含的最后一个序号，
+// 客户端据此丢弃快照已包含的通知，并在发现序号缺口时重新请求快照。
+// 客户端可以连续发送多个请求帧而不等待回复，服务端按收到的顺序逐帧回复。
+// 双方发送的帧都不超过 MaxFrameSize：客户端按字节数拆分批次，服务端对放不下的结果回复 TooLarge。
+namespace TreeProtocol {
+
+constexpr quint32 MaxFrameSize = 16 * 1024 * 1024;  // 单帧上限，超出视为协议错误
+constexpr QDataStream::Version StreamVersion = QDataStream::Qt_6_0;
+const QString DefaultServerName = QStringLiteral("familytree");  // 默认本地套接字名称
+
+enum class FrameType : quint8 {
+    Request = 1,
+    Reply = 2,
+    Notify = 3
+};
+
+// 操作码及参数（均为 QString，按顺序）
+enum class Op : quint8 {
+    ListTrees = 1,  // 无参数；返回 QStringList
+    CreateTree,  // 家谱名
+    AddMember,  // 家谱名, 父节点, 名称, 详细信息
+    AddSpouse,  // 家谱名, 成员, 配偶名称, 配偶详细信息
+    AddSibling,  // 家谱名, 目标节点, 名称, 详细信息
+    ModifyMember,  // 家谱名, 名称, 新详细信息
+    ModifySpouse,  // 家谱名, 成员, 配偶名称, 新详细信息
+    Snapshot,  // 家谱名；返回 家谱名 + quint64 序号 + FamilyTree::save 的输出
+    Subscribe,  // 无参数；之后该连接会收到 Notify 帧
+    ServiceStats  // 无参数；返回服务端 PerfStats::report(true) 的文本（含延迟直方图）
+};
+
+enum class Status : quint8 {
+    Ok = 0,
+    NotFound,  // 家谱不存在
+    Rejected,  // 操作未生效（如成员不存在、重复的家谱或配偶、根节点已存在）
+    BadRequest,  // 未知操作码
+    TooLarge,  // 结果超出单帧上限
+    Disconnected = 0xFF  // 仅在客户端使用：连接断开，操作未发出或未收到回复
+};
+
+// 一个操作及其参数
+struct Operation {
+    Op op;
+    QStringList args;
+};
+
+int argumentCount(Op op);  // 操作的字符串参数个数，未知操作返回 -1
+bool isMutation(Op op);  // 是否会修改家谱
+void writeOperation(QDataStream& out, const Operation& operation);  // 写出操作码与参数
+// 读取一个操作；未知操作码或数据不足时返回 false，可通过流状态区分两者
+bool readOperation(QDataStream& in, Operation& operation);
+// 在家谱上执行一个修改操作（CreateTree 除外），服务端执行请求与客户端重放通知共用
+bool applyMutation(FamilyTree& tree, const Operation& operation);
+QString statusText(Status status);  // 状态的说明文字
+QString describe(const Operation& operation);  // 操作的说明文字，用于提示用户
+
+QByteArray frame(const QByteArray& payload);  // 加上长度前缀
+// 从 buffer 的 offset 处取出一个完整帧的负载并前移 offset；数据不足返回 false，帧过大时置 error
+// 调用方处理完所有帧后再一次性移除已消费的前缀，避免逐帧搬移缓冲区
+bool takeFrame(const QByteArray& buffer, qsizetype& offset, QByteArray& payload, bool& error);
+
+}
+
+#endif // TREEPROTOCOL_H
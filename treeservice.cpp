@@ -0,0 +1,261 @@
+#include "treeservice.h"
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QDataStream>
+#include <QStringList>
+#include <QDebug>
+
+using TreeProtocol::FrameType;
+using TreeProtocol::Op;
+using TreeProtocol::Status;
+
+TreeService::TreeService(QObject *parent) :
+    QObject(parent),
+    server(new QLocalServer(this))
+{
+    connect(server, &QLocalServer::newConnection, this, &TreeService::onNewConnection);
+}
+
+TreeService::~TreeService() {
+    qDeleteAll(familyTrees); // 删除所有家谱对象，释放内存
+}
+
+bool TreeService::listen(const QString& serverName) {
+    if (server->listen(serverName)) {
+        qCInfo(lcFamilyTreeService) << "Listening on" << server->fullServerName();
+        return true;
+    }
+
+    if (server->serverError() == QAbstractSocket::AddressInUseError) {
+        // 套接字可能是上次异常退出遗留的：没有服务应答时清理后重试
+        QLocalSocket probe;
+        probe.connectToServer(serverName);
+        if (!probe.waitForConnected(500)) {
+            QLocalServer::removeServer(serverName);
+            if (server->listen(serverName)) {
+                qCInfo(lcFamilyTreeService) << "Listening on" << server->fullServerName();
+                return true;
+            }
+        }
+    }
+
+    qCWarning(lcFamilyTreeService) << "Failed to listen on" << serverName << ":" << server->errorString();
+    return false;
+}
+
+void TreeService::onNewConnection() {
+    while (QLocalSocket* socket = server->nextPendingConnection()) {
+        connections.insert(socket, Connection());
+        connect(socket, &QLocalSocket::readyRead, this, &TreeService::onReadyRead);
+        connect(socket, &QLocalSocket::disconnected, this, &TreeService::onDisconnected);
+        qCDebug(lcFamilyTreeService) << "Client connected, total:" << connections.size();
+    }
+}
+
+void TreeService::onDisconnected() {
+    auto socket = qobject_cast<QLocalSocket*>(sender());
+    if (!socket) return;
+
+    connections.remove(socket);
+    socket->deleteLater();
+    qCDebug(lcFamilyTreeService) << "Client disconnected, total:" << connections.size();
+}
+
+void TreeService::onReadyRead() {
+    auto socket = qobject_cast<QLocalSocket*>(sender());
+    if (!socket || !connections.contains(socket)) return;
+
+    Connection& connection = connections[socket];
+    connection.buffer.append(socket->readAll());
+
+    // 一次处理缓冲区中所有完整的请求帧，回复合并后一次写出
+    QByteArray replies;
+    ChangeLog changes;
+    qsizetype offset = 0;
+    QByteArray payload;
+    bool protocolError = false;
+    while (TreeProtocol::takeFrame(connection.buffer, offset, payload, protocolError)) {
+        QByteArray reply;
+        {
+            PerfScope perf(PerfOp::ServiceRequest);
+            if (!handleRequest(payload, connection, reply, changes)) {
+                protocolError = true;
+                break;
+            }
+        }
+        replies.append(TreeProtocol::frame(reply));
+    }
+    connection.buffer.remove(0, offset);
+
+    if (!replies.isEmpty()) {
+        socket->write(replies);
+    }
+    notifySubscribers(changes);
+
+    if (protocolError) {
+        // 无法再与该客户端保持帧同步，直接断开；abort 会同步触发 onDisconnected
+        qCWarning(lcFamilyTreeService) << "Protocol error, dropping client";
+        socket->abort();
+    }
+}
+
+bool TreeService::handleRequest(const QByteArray& payload, Connection& connection, QByteArray& reply, ChangeLog& changes) {
+    QDataStream in(payload);
+    in.setVersion(TreeProtocol::StreamVersion);
+
+    quint8 type = 0;
+    quint32 requestId = 0;
+    quint16 count = 0;
+    in >> type >> requestId >> count;
+    if (in.status() != QDataStream::Ok || type != quint8(FrameType::Request)) {
+        return false;
+    }
+
+    QDataStream out(&reply, QIODevice::WriteOnly);
+    out.setVersion(TreeProtocol::StreamVersion);
+    out << quint8(FrameType::Reply) << requestId << count;
+
+    // 遇到未知操作码后无法确定后续参数的边界，剩余操作全部回复 BadRequest
+    bool aborted = false;
+    for (quint16 i = 0; i < count; ++i) {
+        if (aborted) {
+            out << quint8(Status::BadRequest);
+            continue;
+        }
+
+        TreeProtocol::Operation operation;
+        if (!TreeProtocol::readOperation(in, operation)) {
+            if (in.status() != QDataStream::Ok) {
+                return false; // 帧被截断
+            }
+            aborted = true;
+            out << quint8(Status::BadRequest);
+            continue;
+        }
+
+        QByteArray result;
+        QDataStream resultStream(&result, QIODevice::WriteOnly);
+        resultStream.setVersion(TreeProtocol::StreamVersion);
+        const Status status = executeOp(operation, connection, resultStream);
+
+        // 为之后每个结果至少预留 1 字节状态，保证整个回复帧不超过上限；
+        // 修改操作已经生效，它的结果只有 1 字节且已预留，不能改报 TooLarge
+        const qsizetype reserved = count - i - 1;
+        if (!TreeProtocol::isMutation(operation.op)
+            && reply.size() + result.size() + reserved > qsizetype(TreeProtocol::MaxFrameSize)) {
+            out << quint8(Status::TooLarge);
+            qCWarning(lcFamilyTreeService) << "Reply too large for" << TreeProtocol::describe(operation);
+            continue;
+        }
+        out.writeRawData(result.constData(), int(result.size()));
+
+        if (status == Status::Ok && TreeProtocol::isMutation(operation.op)) {
+            TreeChanges& treeChanges = changes[operation.args.value(0)];
+            if (treeChanges.operations.isEmpty()) {
+                treeChanges.firstSequence = treeSequences.value(operation.args.value(0));
+            }
+            treeChanges.operations.append(operation);
+        }
+    }
+    return true;
+}
+
+TreeProtocol::Status TreeService::executeOp(const TreeProtocol::Operation& operation, Connection& connection, QDataStream& result) {
+    const QStringList& args = operation.args;
+
+    // 不针对具体家谱的操作
+    switch (operation.op) {
+    case Op::ListTrees:
+        result << quint8(Status::Ok) << QStringList(familyTrees.keys());
+        return Status::Ok;
+    case Op::Subscribe:
+        connection.subscribed = true;
+        result << quint8(Status::Ok);
+        return Status::Ok;
+    case Op::ServiceStats:
+        result << quint8(Status::Ok) << PerfStats::instance().report(true);
+        return Status::Ok;
+    case Op::CreateTree: {
+        // 家谱名由客户端去除首尾空格，服务端不再改写，以便通知中的操作可以原样重放
+        const QString familyName = args.value(0);
+        if (familyName.trimmed().isEmpty() || familyTrees.contains(familyName)) {
+            result << quint8(Status::Rejected);
+            return Status::Rejected;
+        }
+        auto newTree = new FamilyTree(familyName);
+        newTree->addMember("", familyName, ""); // 与界面一致，以家谱名称作为根节点
+        familyTrees.insert(familyName, newTree);
+        treeSequences.insert(familyName, 1);
+        qCDebug(lcFamilyTreeService) << "Created family tree: " << familyName;
+        result << quint8(Status::Ok);
+        return Status::Ok;
+    }
+    default:
+        break;
+    }
+
+    FamilyTree* tree = familyTrees.value(args.value(0));
+    if (!tree) {
+        result << quint8(Status::NotFound);
+        return Status::NotFound;
+    }
+
+    if (operation.op == Op::Snapshot) {
+        result << quint8(Status::Ok) << tree->getName() << treeSequences.value(tree->getName());
+        tree->save(result);
+        return Status::Ok;
+    }
+
+    const bool applied = TreeProtocol::applyMutation(*tree, operation);
+    if (applied) {
+        ++treeSequences[tree->getName()];
+    }
+    const Status status = applied ? Status::Ok : Status::Rejected;
+    result << quint8(status);
+    return status;
+}
+
+// 组装一个通知帧：家谱名、首个操作的序号、操作数及已编码的操作
+static QByteArray notifyFrame(const QString& treeName, quint64 firstSequence, quint16 count, const QByteArray& encodedOps) {
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(TreeProtocol::StreamVersion);
+    out << quint8(FrameType::Notify) << treeName << firstSequence << count;
+    payload.append(encodedOps);
+    return TreeProtocol::frame(payload);
+}
+
+void TreeService::notifySubscribers(const ChangeLog& changes) {
+    if (changes.isEmpty()) return;
+
+    // 同一轮处理中对同一家谱的修改合并到一个通知帧，超出上限时拆分
+    QByteArray frames;
+    for (auto it = changes.constBegin(); it != changes.constEnd(); ++it) {
+        const qsizetype headerSize = 64 + it.key().size() * qsizetype(sizeof(QChar));
+        QByteArray encodedOps;
+        quint64 firstSequence = it.value().firstSequence;
+        quint16 count = 0;
+        for (const auto& operation : it.value().operations) {
+            QByteArray encoded;
+            QDataStream out(&encoded, QIODevice::WriteOnly);
+            out.setVersion(TreeProtocol::StreamVersion);
+            TreeProtocol::writeOperation(out, operation);
+
+            if (count == 0xFFFF || headerSize + encodedOps.size() + encoded.size() > qsizetype(TreeProtocol::MaxFrameSize)) {
+                frames.append(notifyFrame(it.key(), firstSequence, count, encodedOps));
+                firstSequence += count;
+                encodedOps.clear();
+                count = 0;
+            }
+            encodedOps.append(encoded);
+            ++count;
+        }
+        frames.append(notifyFrame(it.key(), firstSequence, count, encodedOps));
+    }
+
+    for (auto it = connections.constBegin(); it != connections.constEnd(); ++it) {
+        if (it.value().subscribed) {
+            it.key()->write(frames);
+        }
+    }
+}
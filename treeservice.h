@@ -0,0 +1,54 @@
+#ifndef TREESERVICE_H
+#define TREESERVICE_H
+
+#include <QObject>
+#include <QMap>
+#include <QHash>
+#include <QVector>
+#include <QByteArray>
+#include "familytree.h"
+#include "treeprotocol.h"
+
+class QLocalServer;
+class QLocalSocket;
+
+// 无界面的家谱服务：在本地套接字上托管所有家谱，供多个客户端共享同一份数据
+class TreeService : public QObject {
+    Q_OBJECT
+
+public:
+    explicit TreeService(QObject *parent = nullptr);
+    ~TreeService();
+
+    bool listen(const QString& serverName);  // 开始监听，失败时返回 false
+
+private slots:
+    void onNewConnection();  // 接受新客户端
+    void onReadyRead();  // 处理客户端发来的请求帧
+    void onDisconnected();  // 清理断开的客户端
+
+private:
+    // 每个客户端连接的状态
+    struct Connection {
+        QByteArray buffer;  // 尚未处理完的输入数据
+        bool subscribed = false;  // 是否接收变更通知
+    };
+
+    QLocalServer* server;
+    QMap<QString, FamilyTree*> familyTrees;  // 服务端持有的全部家谱
+    QHash<QString, quint64> treeSequences;  // 每棵家谱最近一次生效修改的序号
+    QHash<QLocalSocket*, Connection> connections;
+
+    // 一棵家谱在本轮处理中已生效的修改，序号连续
+    struct TreeChanges {
+        quint64 firstSequence = 0;  // 第一个修改的序号
+        QVector<TreeProtocol::Operation> operations;  // 按执行顺序排列
+    };
+    using ChangeLog = QMap<QString, TreeChanges>;  // 按家谱归类
+
+    bool handleRequest(const QByteArray& payload, Connection& connection, QByteArray& reply, ChangeLog& changes);  // 执行一个请求帧并生成回复帧负载
+    TreeProtocol::Status executeOp(const TreeProtocol::Operation& operation, Connection& connection, QDataStream& result);  // 执行单个操作
+    void notifySubscribers(const ChangeLog& changes);  // 推送变更通知，附带已生效的修改操作
+};
+
+#endif // TREESERVICE_H
@@ -1,9 +1,21 @@
-QT += core gui widgets
+QT += core gui widgets network
 
 SOURCES += main.cpp \
-           mainwindow.cpp
+           mainwindow.cpp \
+           familytree.cpp \
+           treeprotocol.cpp \
+           treeservice.cpp \
+           treeclient.cpp \
+           diagnostics.cpp \
+           diagnosticsdock.cpp
 
-HEADERS += mainwindow.h
+HEADERS += mainwindow.h \
+           familytree.h \
+           treeprotocol.h \
+           treeservice.h \
+           treeclient.h \
+           diagnostics.h \
+           diagnosticsdock.h
 RESOURCES += resources.qrc
 
 FORMS += mainwindow.ui